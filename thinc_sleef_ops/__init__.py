@@ -1,2 +1,2 @@
-from .sleef_array import InstructionSet
+from .sleef_array import Activation, InstructionSet
 from .sleef_ops import SleefOps, with_cpu_feature
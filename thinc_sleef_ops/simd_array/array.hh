@@ -2,6 +2,7 @@
 #define ARRAY_HH
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -14,6 +15,90 @@ struct Array: ArrayBase {
   static size_t const N_FLOAT = Vector<T>::N_FLOAT;
   typedef typename Vector<T>::LOWER_TYPE LOWER_TYPE;
 
+  void adam(double *weights, const double *gradient, double *mom1, double *mom2,
+            size_t n, const AdamParams &params) noexcept;
+
+  double adam_multi(double *const *weights, const double *const *gradients,
+                    double *const *mom1, double *const *mom2, const size_t *sizes,
+                    size_t n_tensors, const AdamParams &params, double grad_clip) noexcept;
+
+  void adam_rows(double *weights, const double *gradient, double *mom1, double *mom2,
+                 int *last_step, const int *rows, size_t n_rows, size_t nO, int step,
+                 const AdamParams &params) noexcept;
+
+  void adamf(float *weights, const float *gradient, float *mom1, float *mom2,
+             size_t n, const AdamParams &params) noexcept;
+
+  double adamf_multi(float *const *weights, const float *const *gradients,
+                     float *const *mom1, float *const *mom2, const size_t *sizes,
+                     size_t n_tensors, const AdamParams &params, double grad_clip) noexcept;
+
+  void adamf_rows(float *weights, const float *gradient, float *mom1, float *mom2,
+                  int *last_step, const int *rows, size_t n_rows, size_t nO, int step,
+                  const AdamParams &params) noexcept;
+
+  void affine(double *Y, const double *X, const double *packed, const double *b,
+              size_t n, size_t nO, size_t nI, Activation activation) noexcept;
+
+  void affine_pack(double *packed, const double *W, size_t nO, size_t nI) noexcept;
+
+  size_t affine_packed_size(size_t nO, size_t nI) noexcept;
+
+  void affinef(float *Y, const float *X, const float *packed, const float *b,
+               size_t n, size_t nO, size_t nI, Activation activation) noexcept;
+
+  void affinef_pack(float *packed, const float *W, size_t nO, size_t nI) noexcept;
+
+  size_t affinef_packed_size(size_t nO, size_t nI) noexcept;
+
+  void argmax(double *best, int *which, const double *X, size_t n, size_t nO) noexcept;
+
+  void argmaxf(float *best, int *which, const float *X, size_t n, size_t nO) noexcept;
+
+  void attention(double *out, const double *Q, const double *K, const double *V,
+                 const int *lengths, size_t n_batch, size_t n_q, size_t n_k,
+                 size_t d, size_t d_v, double scale) noexcept;
+
+  void attentionf(float *out, const float *Q, const float *K, const float *V,
+                  const int *lengths, size_t n_batch, size_t n_q, size_t n_k,
+                  size_t d, size_t d_v, double scale) noexcept;
+
+  void bias_act(double *Y, double *D, const double *b, size_t n, size_t nO,
+                Activation activation) noexcept;
+
+  void bias_act_backward(double *dX, double *db, const double *dY, const double *D,
+                         size_t n, size_t nO) noexcept;
+
+  void bias_actf(float *Y, float *D, const float *b, size_t n, size_t nO,
+                 Activation activation) noexcept;
+
+  void bias_actf_backward(float *dX, float *db, const float *dY, const float *D,
+                          size_t n, size_t nO) noexcept;
+
+  double clip_gradient(double *gradient, size_t n, double threshold) noexcept;
+
+  void clip_gradient_multi(double *const *gradients, const size_t *sizes, size_t n_tensors,
+                           double threshold, double *norms) noexcept;
+
+  double clip_gradientf(float *gradient, size_t n, double threshold) noexcept;
+
+  void clip_gradientf_multi(float *const *gradients, const size_t *sizes, size_t n_tensors,
+                            double threshold, double *norms) noexcept;
+
+  void cosine_similarity(double *out, const double *A, const double *B, size_t n_a,
+                         size_t n_b, size_t d, double eps) noexcept;
+
+  void cosine_similarityf(float *out, const float *A, const float *B, size_t n_a,
+                          size_t n_b, size_t d, double eps) noexcept;
+
+  void dropout(double *X, size_t n, double drop, uint64_t seed, uint64_t offset) noexcept;
+
+  void dropout_mask(double *mask, size_t n, double drop, uint64_t seed, uint64_t offset) noexcept;
+
+  void dropoutf(float *X, size_t n, double drop, uint64_t seed, uint64_t offset) noexcept;
+
+  void dropoutf_mask(float *mask, size_t n, double drop, uint64_t seed, uint64_t offset) noexcept;
+
   void erf(double *a, size_t n) noexcept;
 
   void erff(float *a, size_t n) noexcept;
@@ -22,6 +107,18 @@ struct Array: ArrayBase {
 
   void expf(float *a, size_t n) noexcept;
 
+  void flatten(double *out, const double *const *seqs, const int *lengths,
+               size_t n_seqs, size_t nO, size_t pad) noexcept;
+
+  void flattenf(float *out, const float *const *seqs, const int *lengths,
+                size_t n_seqs, size_t nO, size_t pad) noexcept;
+
+  void gather_add(double *out, const double *table, const int *indices,
+                  size_t n, size_t n_idx, size_t nO) noexcept;
+
+  void gather_addf(float *out, const float *table, const int *indices,
+                   size_t n, size_t n_idx, size_t nO) noexcept;
+
   void gelu(double *a, size_t n) noexcept;
 
   void gelu_backward(double* a, size_t n) noexcept;
@@ -30,10 +127,110 @@ struct Array: ArrayBase {
 
   void geluf_backward(float* a, size_t n) noexcept;
 
+  void hash(uint32_t *out, const uint64_t *keys, size_t n, uint32_t seed) noexcept;
+
+  void hash_embed(double *out, int *keys, const double *table, const uint64_t *ids,
+                  size_t n, size_t nV, size_t nO, uint32_t seed) noexcept;
+
+  void hash_embedf(float *out, int *keys, const float *table, const uint64_t *ids,
+                   size_t n, size_t nV, size_t nO, uint32_t seed) noexcept;
+
+  void l2_normalize(double *X, size_t n, size_t nO, double eps) noexcept;
+
+  void l2_normalizef(float *X, size_t n, size_t nO, double eps) noexcept;
+
   void logistic_cdf(double *a, size_t n) noexcept;
 
   void logistic_cdff(float *a, size_t n) noexcept;
 
+  void lstm_gates(double *Y, double *C, double *G, const double *C_prev, size_t n) noexcept;
+
+  void lstm_gates_backward(double *dG, double *dC_prev, const double *dY, const double *dC,
+                           const double *G, const double *C, const double *C_prev,
+                           size_t n) noexcept;
+
+  void lstm_gatesf(float *Y, float *C, float *G, const float *C_prev, size_t n) noexcept;
+
+  void lstm_gatesf_backward(float *dG, float *dC_prev, const float *dY, const float *dC,
+                            const float *G, const float *C, const float *C_prev,
+                            size_t n) noexcept;
+
+  void masked_softmax(double *X, const int *lengths, size_t n, size_t nO, double scale) noexcept;
+
+  void masked_softmaxf(float *X, const int *lengths, size_t n, size_t nO, double scale) noexcept;
+
+  void maxout(double *best, int *which, const double *X, size_t n, size_t P) noexcept;
+
+  void maxout_backward(double *dX, const double *dY, const int *which, size_t n, size_t P) noexcept;
+
+  void maxout_layer_norm(double *Y, int *which, double *mean, double *var,
+                         const double *X, const double *G, const double *b,
+                         size_t n, size_t nO, size_t nP, double eps) noexcept;
+
+  void maxoutf(float *best, int *which, const float *X, size_t n, size_t P) noexcept;
+
+  void maxoutf_backward(float *dX, const float *dY, const int *which, size_t n, size_t P) noexcept;
+
+  void maxoutf_layer_norm(float *Y, int *which, float *mean, float *var,
+                          const float *X, const float *G, const float *b,
+                          size_t n, size_t nO, size_t nP, float eps) noexcept;
+
+  void ngrams(uint64_t *out, const uint64_t *keys, size_t n, size_t ngram_size) noexcept;
+
+  void pad(double *out, const double *const *seqs, const int *lengths,
+           size_t n_seqs, size_t n_pad, size_t nO, bool time_major) noexcept;
+
+  void padf(float *out, const float *const *seqs, const int *lengths,
+            size_t n_seqs, size_t n_pad, size_t nO, bool time_major) noexcept;
+
+  void position_encode(double *out, size_t N, size_t D, double period) noexcept;
+
+  void position_encodef(float *out, size_t N, size_t D, double period) noexcept;
+
+  void random_normal(double *out, size_t n, double mean, double std, uint64_t seed,
+                     uint64_t offset) noexcept;
+
+  void random_normalf(float *out, size_t n, double mean, double std, uint64_t seed,
+                      uint64_t offset) noexcept;
+
+  void random_uniform(double *out, size_t n, double low, double high, uint64_t seed,
+                      uint64_t offset) noexcept;
+
+  void random_uniformf(float *out, size_t n, double low, double high, uint64_t seed,
+                       uint64_t offset) noexcept;
+
+  void residual_layer_norm(double *Y, double *S, double *mean, double *var,
+                           const double *X, const double *R, const double *G, const double *b,
+                           size_t n, size_t nO, double eps) noexcept;
+
+  void residual_layer_normf(float *Y, float *S, float *mean, float *var,
+                            const float *X, const float *R, const float *G, const float *b,
+                            size_t n, size_t nO, float eps) noexcept;
+
+  void sample(int *out, double *X, size_t n, size_t nO, double temperature, double top_p,
+              uint64_t seed, uint64_t offset) noexcept;
+
+  void samplef(int *out, float *X, size_t n, size_t nO, double temperature, double top_p,
+               uint64_t seed, uint64_t offset) noexcept;
+
+  void scatter_add(double *table, const int *indices, const double *values,
+                   size_t n, size_t n_idx, size_t nO) noexcept;
+
+  void scatter_addf(float *table, const int *indices, const float *values,
+                    size_t n, size_t n_idx, size_t nO) noexcept;
+
+  void seq2col(double *cols, const double *seq, const int *lengths,
+               size_t n_lengths, size_t nW, size_t nI) noexcept;
+
+  void seq2col_backward(double *dX, const double *dY, const int *lengths,
+                        size_t n_lengths, size_t nW, size_t nI) noexcept;
+
+  void seq2colf(float *cols, const float *seq, const int *lengths,
+                size_t n_lengths, size_t nW, size_t nI) noexcept;
+
+  void seq2colf_backward(float *dX, const float *dY, const int *lengths,
+                         size_t n_lengths, size_t nW, size_t nI) noexcept;
+
   void swish(double *a, size_t n) noexcept;
 
   void swish_backward(double* a, size_t n) noexcept;
@@ -45,6 +242,26 @@ struct Array: ArrayBase {
   void tanh(double *a, size_t n) noexcept;
 
   void tanhf(float *a, size_t n) noexcept;
+
+  void top_k(double *values, int *indices, const double *X, size_t n, size_t nO, size_t k) noexcept;
+
+  void top_kf(float *values, int *indices, const float *X, size_t n, size_t nO, size_t k) noexcept;
+
+  void unpad(double *const *seqs, const double *padded, const int *lengths,
+             size_t n_seqs, size_t n_pad, size_t nO, bool time_major) noexcept;
+
+  void unpadf(float *const *seqs, const float *padded, const int *lengths,
+              size_t n_seqs, size_t n_pad, size_t nO, bool time_major) noexcept;
+
+  void update_averages(double *ema, const double *weights, size_t n, double decay) noexcept;
+
+  void update_averages_multi(double *const *ema, const double *const *weights,
+                             const size_t *sizes, size_t n_tensors, double decay) noexcept;
+
+  void update_averagesf(float *ema, const float *weights, size_t n, double decay) noexcept;
+
+  void update_averagesf_multi(float *const *ema, const float *const *weights,
+                              const size_t *sizes, size_t n_tensors, double decay) noexcept;
 };
 
 #endif // ARRAY_HH
@@ -0,0 +1,3 @@
+#include "array_impl.hh"
+
+template struct Array<AVX2>;
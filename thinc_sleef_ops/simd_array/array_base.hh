@@ -1,25 +1,206 @@
 #ifndef ARRAY_BASE_HH
 #define ARRAY_BASE_HH
 
+#include <cstddef>
+#include <cstdint>
+
+// Note: keep in sync with sleef_array.pxd
+enum Activation {
+  ACTIVATION_GELU,
+  ACTIVATION_IDENTITY,
+  ACTIVATION_RELU,
+  ACTIVATION_SIGMOID,
+  ACTIVATION_SWISH,
+  ACTIVATION_TANH,
+};
+
+// Hyperparameters of an Adam update. learn_rate is expected to include
+// the bias correction, as in thinc's Ops.adam.
+struct AdamParams {
+  double beta1;
+  double beta2;
+  double eps;
+  double learn_rate;
+  double mod_rate;
+  // The gradient is multiplied by grad_scale before the update, e.g. to
+  // clip the gradient norm.
+  double grad_scale;
+  // L2 penalty, added to the gradient as L2 * weights.
+  double L2;
+  // Decoupled weight decay, applied after the update as
+  // weights -= weight_decay * weights.
+  double weight_decay;
+};
+
 struct ArrayBase {
   inline ArrayBase() {}
   virtual ~ArrayBase() {}
+  virtual void adam(double *weights, const double *gradient, double *mom1, double *mom2,
+                    size_t n, const AdamParams &params) noexcept = 0;
+  virtual double adam_multi(double *const *weights, const double *const *gradients,
+                            double *const *mom1, double *const *mom2, const size_t *sizes,
+                            size_t n_tensors, const AdamParams &params, double grad_clip) noexcept = 0;
+  virtual void adam_rows(double *weights, const double *gradient, double *mom1, double *mom2,
+                         int *last_step, const int *rows, size_t n_rows, size_t nO, int step,
+                         const AdamParams &params) noexcept = 0;
+  virtual void adamf(float *weights, const float *gradient, float *mom1, float *mom2,
+                     size_t n, const AdamParams &params) noexcept = 0;
+  virtual double adamf_multi(float *const *weights, const float *const *gradients,
+                             float *const *mom1, float *const *mom2, const size_t *sizes,
+                             size_t n_tensors, const AdamParams &params, double grad_clip) noexcept = 0;
+  virtual void adamf_rows(float *weights, const float *gradient, float *mom1, float *mom2,
+                          int *last_step, const int *rows, size_t n_rows, size_t nO, int step,
+                          const AdamParams &params) noexcept = 0;
+  virtual void affine(double *Y, const double *X, const double *packed, const double *b,
+                      size_t n, size_t nO, size_t nI, Activation activation) noexcept = 0;
+  virtual void affine_pack(double *packed, const double *W, size_t nO, size_t nI) noexcept = 0;
+  virtual size_t affine_packed_size(size_t nO, size_t nI) noexcept = 0;
+  virtual void affinef(float *Y, const float *X, const float *packed, const float *b,
+                       size_t n, size_t nO, size_t nI, Activation activation) noexcept = 0;
+  virtual void affinef_pack(float *packed, const float *W, size_t nO, size_t nI) noexcept = 0;
+  virtual size_t affinef_packed_size(size_t nO, size_t nI) noexcept = 0;
+  virtual void argmax(double *best, int *which, const double *X, size_t n, size_t nO) noexcept = 0;
+  virtual void argmaxf(float *best, int *which, const float *X, size_t n, size_t nO) noexcept = 0;
+  virtual void attention(double *out, const double *Q, const double *K, const double *V,
+                         const int *lengths, size_t n_batch, size_t n_q, size_t n_k,
+                         size_t d, size_t d_v, double scale) noexcept = 0;
+  virtual void attentionf(float *out, const float *Q, const float *K, const float *V,
+                          const int *lengths, size_t n_batch, size_t n_q, size_t n_k,
+                          size_t d, size_t d_v, double scale) noexcept = 0;
+  virtual void bias_act(double *Y, double *D, const double *b, size_t n, size_t nO,
+                        Activation activation) noexcept = 0;
+  virtual void bias_act_backward(double *dX, double *db, const double *dY, const double *D,
+                                 size_t n, size_t nO) noexcept = 0;
+  virtual void bias_actf(float *Y, float *D, const float *b, size_t n, size_t nO,
+                         Activation activation) noexcept = 0;
+  virtual void bias_actf_backward(float *dX, float *db, const float *dY, const float *D,
+                                  size_t n, size_t nO) noexcept = 0;
+  virtual double clip_gradient(double *gradient, size_t n, double threshold) noexcept = 0;
+  virtual void clip_gradient_multi(double *const *gradients, const size_t *sizes, size_t n_tensors,
+                                   double threshold, double *norms) noexcept = 0;
+  virtual double clip_gradientf(float *gradient, size_t n, double threshold) noexcept = 0;
+  virtual void clip_gradientf_multi(float *const *gradients, const size_t *sizes, size_t n_tensors,
+                                    double threshold, double *norms) noexcept = 0;
+  virtual void cosine_similarity(double *out, const double *A, const double *B, size_t n_a,
+                                 size_t n_b, size_t d, double eps) noexcept = 0;
+  virtual void cosine_similarityf(float *out, const float *A, const float *B, size_t n_a,
+                                  size_t n_b, size_t d, double eps) noexcept = 0;
+  virtual void dropout(double *X, size_t n, double drop, uint64_t seed, uint64_t offset) noexcept = 0;
+  virtual void dropout_mask(double *mask, size_t n, double drop, uint64_t seed,
+                            uint64_t offset) noexcept = 0;
+  virtual void dropoutf(float *X, size_t n, double drop, uint64_t seed, uint64_t offset) noexcept = 0;
+  virtual void dropoutf_mask(float *mask, size_t n, double drop, uint64_t seed,
+                             uint64_t offset) noexcept = 0;
   virtual void erf(double *a, size_t n) noexcept = 0;
   virtual void erff(float *a, size_t n) noexcept = 0;
   virtual void exp(double *a, size_t n) noexcept = 0;
   virtual void expf(float *a, size_t n) noexcept = 0;
+  virtual void flatten(double *out, const double *const *seqs, const int *lengths,
+                       size_t n_seqs, size_t nO, size_t pad) noexcept = 0;
+  virtual void flattenf(float *out, const float *const *seqs, const int *lengths,
+                        size_t n_seqs, size_t nO, size_t pad) noexcept = 0;
+  virtual void gather_add(double *out, const double *table, const int *indices,
+                          size_t n, size_t n_idx, size_t nO) noexcept = 0;
+  virtual void gather_addf(float *out, const float *table, const int *indices,
+                           size_t n, size_t n_idx, size_t nO) noexcept = 0;
   virtual void gelu(double *a, size_t n) noexcept = 0;
   virtual void gelu_backward(double* a, size_t n) noexcept = 0;
   virtual void geluf(float *a, size_t n) noexcept = 0;
   virtual void geluf_backward(float* a, size_t n) noexcept = 0;
+  virtual void hash(uint32_t *out, const uint64_t *keys, size_t n, uint32_t seed) noexcept = 0;
+  virtual void hash_embed(double *out, int *keys, const double *table, const uint64_t *ids,
+                          size_t n, size_t nV, size_t nO, uint32_t seed) noexcept = 0;
+  virtual void hash_embedf(float *out, int *keys, const float *table, const uint64_t *ids,
+                           size_t n, size_t nV, size_t nO, uint32_t seed) noexcept = 0;
+  virtual void l2_normalize(double *X, size_t n, size_t nO, double eps) noexcept = 0;
+  virtual void l2_normalizef(float *X, size_t n, size_t nO, double eps) noexcept = 0;
   virtual void logistic_cdf(double *a, size_t n) noexcept = 0;
   virtual void logistic_cdff(float *a, size_t n) noexcept = 0;
+  virtual void lstm_gates(double *Y, double *C, double *G, const double *C_prev,
+                          size_t n) noexcept = 0;
+  virtual void lstm_gates_backward(double *dG, double *dC_prev, const double *dY,
+                                   const double *dC, const double *G, const double *C,
+                                   const double *C_prev, size_t n) noexcept = 0;
+  virtual void lstm_gatesf(float *Y, float *C, float *G, const float *C_prev,
+                           size_t n) noexcept = 0;
+  virtual void lstm_gatesf_backward(float *dG, float *dC_prev, const float *dY,
+                                    const float *dC, const float *G, const float *C,
+                                    const float *C_prev, size_t n) noexcept = 0;
+  virtual void masked_softmax(double *X, const int *lengths, size_t n, size_t nO,
+                              double scale) noexcept = 0;
+  virtual void masked_softmaxf(float *X, const int *lengths, size_t n, size_t nO,
+                               double scale) noexcept = 0;
+  virtual void maxout(double *best, int *which, const double *X, size_t n, size_t P) noexcept = 0;
+  virtual void maxout_backward(double *dX, const double *dY, const int *which, size_t n, size_t P) noexcept = 0;
+  virtual void maxout_layer_norm(double *Y, int *which, double *mean, double *var,
+                                 const double *X, const double *G, const double *b,
+                                 size_t n, size_t nO, size_t nP, double eps) noexcept = 0;
+  virtual void maxoutf(float *best, int *which, const float *X, size_t n, size_t P) noexcept = 0;
+  virtual void maxoutf_backward(float *dX, const float *dY, const int *which, size_t n, size_t P) noexcept = 0;
+  virtual void maxoutf_layer_norm(float *Y, int *which, float *mean, float *var,
+                                  const float *X, const float *G, const float *b,
+                                  size_t n, size_t nO, size_t nP, float eps) noexcept = 0;
+  virtual void ngrams(uint64_t *out, const uint64_t *keys, size_t n, size_t ngram_size) noexcept = 0;
+  virtual void pad(double *out, const double *const *seqs, const int *lengths,
+                   size_t n_seqs, size_t n_pad, size_t nO, bool time_major) noexcept = 0;
+  virtual void padf(float *out, const float *const *seqs, const int *lengths,
+                    size_t n_seqs, size_t n_pad, size_t nO, bool time_major) noexcept = 0;
+  virtual void position_encode(double *out, size_t N, size_t D, double period) noexcept = 0;
+  virtual void position_encodef(float *out, size_t N, size_t D, double period) noexcept = 0;
+  virtual void random_normal(double *out, size_t n, double mean, double std, uint64_t seed,
+                             uint64_t offset) noexcept = 0;
+  virtual void random_normalf(float *out, size_t n, double mean, double std, uint64_t seed,
+                              uint64_t offset) noexcept = 0;
+  virtual void random_uniform(double *out, size_t n, double low, double high, uint64_t seed,
+                              uint64_t offset) noexcept = 0;
+  virtual void random_uniformf(float *out, size_t n, double low, double high, uint64_t seed,
+                               uint64_t offset) noexcept = 0;
+  virtual void residual_layer_norm(double *Y, double *S, double *mean, double *var,
+                                   const double *X, const double *R, const double *G, const double *b,
+                                   size_t n, size_t nO, double eps) noexcept = 0;
+  virtual void residual_layer_normf(float *Y, float *S, float *mean, float *var,
+                                    const float *X, const float *R, const float *G, const float *b,
+                                    size_t n, size_t nO, float eps) noexcept = 0;
+  virtual void sample(int *out, double *X, size_t n, size_t nO, double temperature, double top_p,
+                      uint64_t seed, uint64_t offset) noexcept = 0;
+  virtual void samplef(int *out, float *X, size_t n, size_t nO, double temperature, double top_p,
+                       uint64_t seed, uint64_t offset) noexcept = 0;
+  virtual void scatter_add(double *table, const int *indices, const double *values,
+                           size_t n, size_t n_idx, size_t nO) noexcept = 0;
+  virtual void scatter_addf(float *table, const int *indices, const float *values,
+                            size_t n, size_t n_idx, size_t nO) noexcept = 0;
+  virtual void seq2col(double *cols, const double *seq, const int *lengths,
+                       size_t n_lengths, size_t nW, size_t nI) noexcept = 0;
+  virtual void seq2col_backward(double *dX, const double *dY, const int *lengths,
+                                size_t n_lengths, size_t nW, size_t nI) noexcept = 0;
+  virtual void seq2colf(float *cols, const float *seq, const int *lengths,
+                        size_t n_lengths, size_t nW, size_t nI) noexcept = 0;
+  virtual void seq2colf_backward(float *dX, const float *dY, const int *lengths,
+                                 size_t n_lengths, size_t nW, size_t nI) noexcept = 0;
   virtual void swish(double *a, size_t n) noexcept = 0;
   virtual void swish_backward(double* a, size_t n) noexcept = 0;
   virtual void swishf(float *a, size_t n) noexcept = 0;
   virtual void swishf_backward(float* a, size_t n) noexcept = 0;
   virtual void tanh(double *a, size_t n) noexcept = 0;
   virtual void tanhf(float *a, size_t n) noexcept = 0;
+  virtual void top_k(double *values, int *indices, const double *X, size_t n, size_t nO,
+                     size_t k) noexcept = 0;
+  virtual void top_kf(float *values, int *indices, const float *X, size_t n, size_t nO,
+                      size_t k) noexcept = 0;
+  virtual void unpad(double *const *seqs, const double *padded, const int *lengths,
+                     size_t n_seqs, size_t n_pad, size_t nO, bool time_major) noexcept = 0;
+  virtual void unpadf(float *const *seqs, const float *padded, const int *lengths,
+                      size_t n_seqs, size_t n_pad, size_t nO, bool time_major) noexcept = 0;
+  virtual void update_averages(double *ema, const double *weights, size_t n,
+                               double decay) noexcept = 0;
+  virtual void update_averages_multi(double *const *ema, const double *const *weights,
+                                     const size_t *sizes, size_t n_tensors,
+                                     double decay) noexcept = 0;
+  virtual void update_averagesf(float *ema, const float *weights, size_t n,
+                                double decay) noexcept = 0;
+  virtual void update_averagesf_multi(float *const *ema, const float *const *weights,
+                                      const size_t *sizes, size_t n_tensors,
+                                      double decay) noexcept = 0;
 };
 
 #endif // ARRAY_BASE_HH
@@ -1,8 +1,12 @@
 #ifndef ARRAY_IMPL_H_
 #define ARRAY_IMPL_H_
 
+#include <algorithm>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
 #include <vector>
 
 #include "../simd_vector/vector.hh"
@@ -19,11 +23,98 @@
 #include "simd_vector/vector_avx.hh"
 #endif
 
+#if defined(__AVX2__)
+#include "simd_vector/vector_avx2.hh"
+#endif
+
 #if defined(__AVX512F__)
 #include "simd_vector/vector_avx512.hh"
 #endif
 
 #include "array_base.hh"
+#include "philox.hh"
+
+// Activations for the fused kernels. backward receives both the input and
+// the output of forward, so that derivatives can reuse the latter.
+
+struct GeluActivation {
+  template <class V>
+  static typename V::TYPE forward(typename V::TYPE x) noexcept {
+    // GELU(x) = x · Φ(x)
+    return V::mul(x, V::normal_cdf(x));
+  }
+
+  template <class V>
+  static typename V::TYPE backward(typename V::TYPE x, typename V::TYPE) noexcept {
+    // GELU'(x) = Φ(x) + x · PDF(x)
+    return V::add(V::mul(x, V::normal_pdf(x)), V::normal_cdf(x));
+  }
+};
+
+struct IdentityActivation {
+  template <class V>
+  static typename V::TYPE forward(typename V::TYPE x) noexcept {
+    return x;
+  }
+
+  template <class V>
+  static typename V::TYPE backward(typename V::TYPE, typename V::TYPE) noexcept {
+    return V::broadcast(1);
+  }
+};
+
+struct ReluActivation {
+  template <class V>
+  static typename V::TYPE forward(typename V::TYPE x) noexcept {
+    return V::max(x, V::broadcast(0));
+  }
+
+  template <class V>
+  static typename V::TYPE backward(typename V::TYPE x, typename V::TYPE) noexcept {
+    auto zero = V::broadcast(0);
+    return V::select_gt(x, zero, V::broadcast(1), zero);
+  }
+};
+
+struct SigmoidActivation {
+  template <class V>
+  static typename V::TYPE forward(typename V::TYPE x) noexcept {
+    return V::logistic_cdf(x);
+  }
+
+  template <class V>
+  static typename V::TYPE backward(typename V::TYPE, typename V::TYPE y) noexcept {
+    // σ'(x) = σ(x) · (1 - σ(x))
+    return V::mul(y, V::sub(V::broadcast(1), y));
+  }
+};
+
+struct SwishActivation {
+  template <class V>
+  static typename V::TYPE forward(typename V::TYPE x) noexcept {
+    // swish(x) = x · σ(x)
+    return V::mul(x, V::logistic_cdf(x));
+  }
+
+  template <class V>
+  static typename V::TYPE backward(typename V::TYPE x, typename V::TYPE) noexcept {
+    // swish'(x) = σ(x) + x · PDF(x)
+    return V::add(V::mul(x, V::logistic_pdf(x)), V::logistic_cdf(x));
+  }
+};
+
+struct TanhActivation {
+  template <class V>
+  static typename V::TYPE forward(typename V::TYPE x) noexcept {
+    return V::tanh(x);
+  }
+
+  template <class V>
+  static typename V::TYPE backward(typename V::TYPE, typename V::TYPE y) noexcept {
+    // tanh'(x) = 1 - tanh²(x)
+    return V::sub(V::broadcast(1), V::mul(y, y));
+  }
+};
 
 template <class T>
 struct Array : ArrayBase {
@@ -32,6 +123,150 @@ struct Array : ArrayBase {
 
   typedef typename Vector<T>::LOWER_TYPE LOWER_TYPE;
 
+  void adam(double *weights, const double *gradient, double *mom1, double *mom2,
+            size_t n, const AdamParams &params) noexcept {
+    adam_generic(weights, gradient, mom1, mom2, n, params);
+  }
+
+  double adam_multi(double *const *weights, const double *const *gradients,
+                    double *const *mom1, double *const *mom2, const size_t *sizes,
+                    size_t n_tensors, const AdamParams &params, double grad_clip) noexcept {
+    return adam_multi_generic(weights, gradients, mom1, mom2, sizes, n_tensors, params, grad_clip);
+  }
+
+  void adam_rows(double *weights, const double *gradient, double *mom1, double *mom2,
+                 int *last_step, const int *rows, size_t n_rows, size_t nO, int step,
+                 const AdamParams &params) noexcept {
+    adam_rows_generic(weights, gradient, mom1, mom2, last_step, rows, n_rows, nO, step, params);
+  }
+
+  void adamf(float *weights, const float *gradient, float *mom1, float *mom2,
+             size_t n, const AdamParams &params) noexcept {
+    adam_generic(weights, gradient, mom1, mom2, n, params);
+  }
+
+  void adamf_rows(float *weights, const float *gradient, float *mom1, float *mom2,
+                  int *last_step, const int *rows, size_t n_rows, size_t nO, int step,
+                  const AdamParams &params) noexcept {
+    adam_rows_generic(weights, gradient, mom1, mom2, last_step, rows, n_rows, nO, step, params);
+  }
+
+  double adamf_multi(float *const *weights, const float *const *gradients,
+                     float *const *mom1, float *const *mom2, const size_t *sizes,
+                     size_t n_tensors, const AdamParams &params, double grad_clip) noexcept {
+    return adam_multi_generic(weights, gradients, mom1, mom2, sizes, n_tensors, params, grad_clip);
+  }
+
+  void affine(double *Y, const double *X, const double *packed, const double *b,
+              size_t n, size_t nO, size_t nI, Activation activation) noexcept {
+    affine_generic(Y, X, packed, b, n, nO, nI, activation);
+  }
+
+  void affine_pack(double *packed, const double *W, size_t nO, size_t nI) noexcept {
+    affine_pack_generic(packed, W, nO, nI);
+  }
+
+  size_t affine_packed_size(size_t nO, size_t nI) noexcept {
+    return affine_packed_size_generic<double>(nO, nI);
+  }
+
+  void affinef(float *Y, const float *X, const float *packed, const float *b,
+               size_t n, size_t nO, size_t nI, Activation activation) noexcept {
+    affine_generic(Y, X, packed, b, n, nO, nI, activation);
+  }
+
+  void affinef_pack(float *packed, const float *W, size_t nO, size_t nI) noexcept {
+    affine_pack_generic(packed, W, nO, nI);
+  }
+
+  size_t affinef_packed_size(size_t nO, size_t nI) noexcept {
+    return affine_packed_size_generic<float>(nO, nI);
+  }
+
+  void argmax(double *best, int *which, const double *X, size_t n, size_t nO) noexcept {
+    argmax_generic(best, which, X, n, nO);
+  }
+
+  void argmaxf(float *best, int *which, const float *X, size_t n, size_t nO) noexcept {
+    argmax_generic(best, which, X, n, nO);
+  }
+
+  void attention(double *out, const double *Q, const double *K, const double *V,
+                 const int *lengths, size_t n_batch, size_t n_q, size_t n_k,
+                 size_t d, size_t d_v, double scale) noexcept {
+    attention_generic(out, Q, K, V, lengths, n_batch, n_q, n_k, d, d_v, scale);
+  }
+
+  void attentionf(float *out, const float *Q, const float *K, const float *V,
+                  const int *lengths, size_t n_batch, size_t n_q, size_t n_k,
+                  size_t d, size_t d_v, double scale) noexcept {
+    attention_generic(out, Q, K, V, lengths, n_batch, n_q, n_k, d, d_v, scale);
+  }
+
+  void bias_act(double *Y, double *D, const double *b, size_t n, size_t nO,
+                Activation activation) noexcept {
+    bias_act_generic(Y, D, b, n, nO, activation);
+  }
+
+  void bias_act_backward(double *dX, double *db, const double *dY, const double *D,
+                         size_t n, size_t nO) noexcept {
+    bias_act_backward_generic(dX, db, dY, D, n, nO);
+  }
+
+  void bias_actf(float *Y, float *D, const float *b, size_t n, size_t nO,
+                 Activation activation) noexcept {
+    bias_act_generic(Y, D, b, n, nO, activation);
+  }
+
+  void bias_actf_backward(float *dX, float *db, const float *dY, const float *D,
+                          size_t n, size_t nO) noexcept {
+    bias_act_backward_generic(dX, db, dY, D, n, nO);
+  }
+
+  double clip_gradient(double *gradient, size_t n, double threshold) noexcept {
+    return clip_gradient_generic(gradient, n, threshold);
+  }
+
+  void clip_gradient_multi(double *const *gradients, const size_t *sizes, size_t n_tensors,
+                           double threshold, double *norms) noexcept {
+    clip_gradient_multi_generic(gradients, sizes, n_tensors, threshold, norms);
+  }
+
+  double clip_gradientf(float *gradient, size_t n, double threshold) noexcept {
+    return clip_gradient_generic(gradient, n, threshold);
+  }
+
+  void clip_gradientf_multi(float *const *gradients, const size_t *sizes, size_t n_tensors,
+                            double threshold, double *norms) noexcept {
+    clip_gradient_multi_generic(gradients, sizes, n_tensors, threshold, norms);
+  }
+
+  void cosine_similarity(double *out, const double *A, const double *B, size_t n_a,
+                         size_t n_b, size_t d, double eps) noexcept {
+    cosine_similarity_generic(out, A, B, n_a, n_b, d, eps);
+  }
+
+  void cosine_similarityf(float *out, const float *A, const float *B, size_t n_a,
+                          size_t n_b, size_t d, double eps) noexcept {
+    cosine_similarity_generic(out, A, B, n_a, n_b, d, eps);
+  }
+
+  void dropout(double *X, size_t n, double drop, uint64_t seed, uint64_t offset) noexcept {
+    dropout_generic<false>(X, n, drop, seed, offset);
+  }
+
+  void dropout_mask(double *mask, size_t n, double drop, uint64_t seed, uint64_t offset) noexcept {
+    dropout_generic<true>(mask, n, drop, seed, offset);
+  }
+
+  void dropoutf(float *X, size_t n, double drop, uint64_t seed, uint64_t offset) noexcept {
+    dropout_generic<false>(X, n, drop, seed, offset);
+  }
+
+  void dropoutf_mask(float *mask, size_t n, double drop, uint64_t seed, uint64_t offset) noexcept {
+    dropout_generic<true>(mask, n, drop, seed, offset);
+  }
+
   void erf(double *a, size_t n) noexcept {
     apply_elementwise(Vector<T>::erf, &Array<LOWER_TYPE>::erf, a, n);
   }
@@ -48,6 +283,26 @@ struct Array : ArrayBase {
     apply_elementwise(Vector<T>::expf, &Array<LOWER_TYPE>::expf, a, n);
   }
 
+  void flatten(double *out, const double *const *seqs, const int *lengths,
+               size_t n_seqs, size_t nO, size_t pad) noexcept {
+    flatten_generic(out, seqs, lengths, n_seqs, nO, pad);
+  }
+
+  void flattenf(float *out, const float *const *seqs, const int *lengths,
+                size_t n_seqs, size_t nO, size_t pad) noexcept {
+    flatten_generic(out, seqs, lengths, n_seqs, nO, pad);
+  }
+
+  void gather_add(double *out, const double *table, const int *indices,
+                  size_t n, size_t n_idx, size_t nO) noexcept {
+    gather_add_generic(out, table, indices, n, n_idx, nO);
+  }
+
+  void gather_addf(float *out, const float *table, const int *indices,
+                   size_t n, size_t n_idx, size_t nO) noexcept {
+    gather_add_generic(out, table, indices, n, n_idx, nO);
+  }
+
   void gelu(double *a, size_t n) noexcept {
     apply_elementwise([](auto a) {
       // GELU(x) = x · Φ(x)
@@ -84,6 +339,28 @@ struct Array : ArrayBase {
     }, &Array<LOWER_TYPE>::geluf_backward, a, n);
   }
 
+  void hash(uint32_t *out, const uint64_t *keys, size_t n, uint32_t seed) noexcept {
+    hash_generic(out, keys, n, seed);
+  }
+
+  void hash_embed(double *out, int *keys, const double *table, const uint64_t *ids,
+                  size_t n, size_t nV, size_t nO, uint32_t seed) noexcept {
+    hash_embed_generic(out, keys, table, ids, n, nV, nO, seed);
+  }
+
+  void hash_embedf(float *out, int *keys, const float *table, const uint64_t *ids,
+                   size_t n, size_t nV, size_t nO, uint32_t seed) noexcept {
+    hash_embed_generic(out, keys, table, ids, n, nV, nO, seed);
+  }
+
+  void l2_normalize(double *X, size_t n, size_t nO, double eps) noexcept {
+    l2_normalize_generic(X, n, nO, eps);
+  }
+
+  void l2_normalizef(float *X, size_t n, size_t nO, double eps) noexcept {
+    l2_normalize_generic(X, n, nO, eps);
+  }
+
   void logistic_cdf(double *a, size_t n) noexcept {
     apply_elementwise(Vector<T>::logistic_cdf, &Array<LOWER_TYPE>::logistic_cdf, a, n);
   }
@@ -92,6 +369,156 @@ struct Array : ArrayBase {
     apply_elementwise(Vector<T>::logistic_cdff, &Array<LOWER_TYPE>::logistic_cdff, a, n);
   }
 
+  void lstm_gates(double *Y, double *C, double *G, const double *C_prev, size_t n) noexcept {
+    lstm_gates_generic(Y, C, G, C_prev, n);
+  }
+
+  void lstm_gates_backward(double *dG, double *dC_prev, const double *dY, const double *dC,
+                           const double *G, const double *C, const double *C_prev,
+                           size_t n) noexcept {
+    lstm_gates_backward_generic(dG, dC_prev, dY, dC, G, C, C_prev, n);
+  }
+
+  void lstm_gatesf(float *Y, float *C, float *G, const float *C_prev, size_t n) noexcept {
+    lstm_gates_generic(Y, C, G, C_prev, n);
+  }
+
+  void lstm_gatesf_backward(float *dG, float *dC_prev, const float *dY, const float *dC,
+                            const float *G, const float *C, const float *C_prev,
+                            size_t n) noexcept {
+    lstm_gates_backward_generic(dG, dC_prev, dY, dC, G, C, C_prev, n);
+  }
+
+  void masked_softmax(double *X, const int *lengths, size_t n, size_t nO, double scale) noexcept {
+    masked_softmax_generic(X, lengths, n, nO, scale);
+  }
+
+  void masked_softmaxf(float *X, const int *lengths, size_t n, size_t nO, double scale) noexcept {
+    masked_softmax_generic(X, lengths, n, nO, scale);
+  }
+
+  void maxout(double *best, int *which, const double *X, size_t n, size_t P) noexcept {
+    maxout_generic(best, which, X, n, P);
+  }
+
+  void maxout_layer_norm(double *Y, int *which, double *mean, double *var,
+                         const double *X, const double *G, const double *b,
+                         size_t n, size_t nO, size_t nP, double eps) noexcept {
+    maxout_layer_norm_generic(Y, which, mean, var, X, G, b, n, nO, nP, eps);
+  }
+
+  void maxout_backward(double *dX, const double *dY, const int *which, size_t n, size_t P) noexcept {
+    maxout_backward_generic(dX, dY, which, n, P);
+  }
+
+  void maxoutf(float *best, int *which, const float *X, size_t n, size_t P) noexcept {
+    maxout_generic(best, which, X, n, P);
+  }
+
+  void maxoutf_layer_norm(float *Y, int *which, float *mean, float *var,
+                          const float *X, const float *G, const float *b,
+                          size_t n, size_t nO, size_t nP, float eps) noexcept {
+    maxout_layer_norm_generic(Y, which, mean, var, X, G, b, n, nO, nP, eps);
+  }
+
+  void maxoutf_backward(float *dX, const float *dY, const int *which, size_t n, size_t P) noexcept {
+    maxout_backward_generic(dX, dY, which, n, P);
+  }
+
+  void ngrams(uint64_t *out, const uint64_t *keys, size_t n, size_t ngram_size) noexcept {
+    ngrams_generic(out, keys, n, ngram_size);
+  }
+
+  void pad(double *out, const double *const *seqs, const int *lengths,
+           size_t n_seqs, size_t n_pad, size_t nO, bool time_major) noexcept {
+    pad_generic(out, seqs, lengths, n_seqs, n_pad, nO, time_major);
+  }
+
+  void padf(float *out, const float *const *seqs, const int *lengths,
+            size_t n_seqs, size_t n_pad, size_t nO, bool time_major) noexcept {
+    pad_generic(out, seqs, lengths, n_seqs, n_pad, nO, time_major);
+  }
+
+  void position_encode(double *out, size_t N, size_t D, double period) noexcept {
+    position_encode_generic(out, N, D, period);
+  }
+
+  void position_encodef(float *out, size_t N, size_t D, double period) noexcept {
+    position_encode_generic(out, N, D, period);
+  }
+
+  void random_normal(double *out, size_t n, double mean, double std, uint64_t seed,
+                     uint64_t offset) noexcept {
+    random_normal_generic(out, n, mean, std, seed, offset);
+  }
+
+  void random_normalf(float *out, size_t n, double mean, double std, uint64_t seed,
+                      uint64_t offset) noexcept {
+    random_normal_generic(out, n, mean, std, seed, offset);
+  }
+
+  void random_uniform(double *out, size_t n, double low, double high, uint64_t seed,
+                      uint64_t offset) noexcept {
+    random_uniform_generic(out, n, low, high, seed, offset);
+  }
+
+  void random_uniformf(float *out, size_t n, double low, double high, uint64_t seed,
+                       uint64_t offset) noexcept {
+    random_uniform_generic(out, n, low, high, seed, offset);
+  }
+
+  void residual_layer_norm(double *Y, double *S, double *mean, double *var,
+                           const double *X, const double *R, const double *G, const double *b,
+                           size_t n, size_t nO, double eps) noexcept {
+    residual_layer_norm_generic(Y, S, mean, var, X, R, G, b, n, nO, eps);
+  }
+
+  void residual_layer_normf(float *Y, float *S, float *mean, float *var,
+                            const float *X, const float *R, const float *G, const float *b,
+                            size_t n, size_t nO, float eps) noexcept {
+    residual_layer_norm_generic(Y, S, mean, var, X, R, G, b, n, nO, eps);
+  }
+
+  void sample(int *out, double *X, size_t n, size_t nO, double temperature, double top_p,
+              uint64_t seed, uint64_t offset) noexcept {
+    sample_generic(out, X, n, nO, temperature, top_p, seed, offset);
+  }
+
+  void samplef(int *out, float *X, size_t n, size_t nO, double temperature, double top_p,
+               uint64_t seed, uint64_t offset) noexcept {
+    sample_generic(out, X, n, nO, temperature, top_p, seed, offset);
+  }
+
+  void scatter_add(double *table, const int *indices, const double *values,
+                   size_t n, size_t n_idx, size_t nO) noexcept {
+    scatter_add_generic(table, indices, values, n, n_idx, nO);
+  }
+
+  void scatter_addf(float *table, const int *indices, const float *values,
+                    size_t n, size_t n_idx, size_t nO) noexcept {
+    scatter_add_generic(table, indices, values, n, n_idx, nO);
+  }
+
+  void seq2col(double *cols, const double *seq, const int *lengths,
+               size_t n_lengths, size_t nW, size_t nI) noexcept {
+    seq2col_generic(cols, seq, lengths, n_lengths, nW, nI);
+  }
+
+  void seq2col_backward(double *dX, const double *dY, const int *lengths,
+                        size_t n_lengths, size_t nW, size_t nI) noexcept {
+    seq2col_backward_generic(dX, dY, lengths, n_lengths, nW, nI);
+  }
+
+  void seq2colf(float *cols, const float *seq, const int *lengths,
+                size_t n_lengths, size_t nW, size_t nI) noexcept {
+    seq2col_generic(cols, seq, lengths, n_lengths, nW, nI);
+  }
+
+  void seq2colf_backward(float *dX, const float *dY, const int *lengths,
+                         size_t n_lengths, size_t nW, size_t nI) noexcept {
+    seq2col_backward_generic(dX, dY, lengths, n_lengths, nW, nI);
+  }
+
   void swish(double *a, size_t n) noexcept {
     apply_elementwise([](auto a) {
       // swish(x) = x · σ(x)
@@ -136,32 +563,1600 @@ struct Array : ArrayBase {
     apply_elementwise(Vector<T>::tanhf, &Array<LOWER_TYPE>::tanhf, a, n);
   }
 
+  void top_k(double *values, int *indices, const double *X, size_t n, size_t nO, size_t k) noexcept {
+    top_k_generic(values, indices, X, n, nO, k);
+  }
+
+  void top_kf(float *values, int *indices, const float *X, size_t n, size_t nO, size_t k) noexcept {
+    top_k_generic(values, indices, X, n, nO, k);
+  }
+
+  void unpad(double *const *seqs, const double *padded, const int *lengths,
+             size_t n_seqs, size_t n_pad, size_t nO, bool time_major) noexcept {
+    unpad_generic(seqs, padded, lengths, n_seqs, n_pad, nO, time_major);
+  }
+
+  void unpadf(float *const *seqs, const float *padded, const int *lengths,
+              size_t n_seqs, size_t n_pad, size_t nO, bool time_major) noexcept {
+    unpad_generic(seqs, padded, lengths, n_seqs, n_pad, nO, time_major);
+  }
+
+  void update_averages(double *ema, const double *weights, size_t n, double decay) noexcept {
+    update_averages_generic(ema, weights, n, decay);
+  }
+
+  void update_averages_multi(double *const *ema, const double *const *weights,
+                             const size_t *sizes, size_t n_tensors, double decay) noexcept {
+    for (size_t i = 0; i != n_tensors; ++i) {
+      update_averages_generic(ema[i], weights[i], sizes[i], decay);
+    }
+  }
+
+  void update_averagesf(float *ema, const float *weights, size_t n, double decay) noexcept {
+    update_averages_generic(ema, weights, n, decay);
+  }
+
+  void update_averagesf_multi(float *const *ema, const float *const *weights,
+                              const size_t *sizes, size_t n_tensors, double decay) noexcept {
+    for (size_t i = 0; i != n_tensors; ++i) {
+      update_averages_generic(ema[i], weights[i], sizes[i], decay);
+    }
+  }
+
 private:
-  template <class F, class G>
-  static void apply_elementwise(F f, G f_rest, float *a, size_t n) {
-    size_t upper = n - (n % N_FLOAT);
-    for (float *cur = a; cur != a + upper; cur += N_FLOAT) {
-      Vector<T>::with_load_store(f, cur);
+  // Narrower instruction sets handle the remainder of our vector loops.
+  template <class U> friend struct Array;
+
+  // Single pass over the parameters, the L2 penalty and gradient scale
+  // are applied in the order of thinc's Optimizer:
+  //
+  // g = (gradient + L2 * weights) * grad_scale
+  // mom1 = beta1 * mom1 + (1 - beta1) * g
+  // mom2 = beta2 * mom2 + (1 - beta2) * g²
+  // weights -= learn_rate * mom1 / (mod_rate * sqrt(mom2) + eps)
+  // weights -= weight_decay * weights
+  template <class U>
+  static void adam_generic(U *weights, const U *gradient, U *mom1, U *mom2,
+                           size_t n, const AdamParams &params) noexcept {
+    adam_decayed(weights, gradient, mom1, mom2, n, params, params.beta1, params.beta2);
+  }
+
+  // adam_generic with the decays of the old moments given separately from
+  // the parameters, which the row-sparse update needs to catch up on
+  // skipped steps.
+  template <class U>
+  static void adam_decayed(U *weights, const U *gradient, U *mom1, U *mom2, size_t n,
+                           const AdamParams &params, double mom1_decay, double mom2_decay) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto beta1 = V::broadcast(mom1_decay);
+    auto beta2 = V::broadcast(mom2_decay);
+    auto one_minus_beta1 = V::broadcast(1.0 - params.beta1);
+    auto one_minus_beta2 = V::broadcast(1.0 - params.beta2);
+    auto eps = V::broadcast(params.eps);
+    auto neg_learn_rate = V::broadcast(-params.learn_rate);
+    auto mod_rate = V::broadcast(params.mod_rate);
+    auto grad_scale = V::broadcast(params.grad_scale);
+    auto L2 = V::broadcast(params.L2);
+    auto decay = V::broadcast(1.0 - params.weight_decay);
+
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      auto w = V::load(weights + i);
+      auto g = V::mul(V::fma(L2, w, V::load(gradient + i)), grad_scale);
+      auto m1 = V::fma(beta1, V::load(mom1 + i), V::mul(one_minus_beta1, g));
+      auto m2 = V::fma(beta2, V::load(mom2 + i), V::mul(V::mul(one_minus_beta2, g), g));
+      auto step = V::div(m1, V::fma(mod_rate, V::sqrt(m2), eps));
+      w = V::mul(V::fma(neg_learn_rate, step, w), decay);
+      V::store(mom1 + i, m1);
+      V::store(mom2 + i, m2);
+      V::store(weights + i, w);
     }
 
     if (upper != n) {
-      Array<LOWER_TYPE> array_lower;
-      (array_lower.*f_rest)(a + upper, n - upper);
+      Array<LOWER_TYPE>::adam_decayed(weights + upper, gradient + upper, mom1 + upper,
+                                      mom2 + upper, n - upper, params, mom1_decay, mom2_decay);
     }
   }
 
-  template <class F, class G>
-  static void apply_elementwise(F f, G f_rest, double *a, size_t n) {
-    size_t upper = n - (n % N_DOUBLE);
-    for (double *cur = a; cur != a + upper; cur += N_DOUBLE) {
-      Vector<T>::with_load_store(f, cur);
+  // Adam update of several parameters with the gradients clipped by their
+  // global norm. The first sweep computes the norm of the gradients (with
+  // the L2 penalty, which thinc's Optimizer adds before clipping), the
+  // second sweep updates the parameters. Returns the global norm.
+  template <class U>
+  static double adam_multi_generic(U *const *weights, const U *const *gradients,
+                                   U *const *mom1, U *const *mom2, const size_t *sizes,
+                                   size_t n_tensors, const AdamParams &params,
+                                   double grad_clip) noexcept {
+    double sum_squared = 0.0;
+    for (size_t i = 0; i != n_tensors; ++i) {
+      sum_squared += adam_gradient_sum_squared(gradients[i], weights[i], U(params.L2), sizes[i]);
     }
 
+    double norm = std::sqrt(sum_squared);
+    AdamParams clipped = params;
+    if (grad_clip > 0.0 && norm >= grad_clip) {
+      clipped.grad_scale *= grad_clip / norm;
+    }
+
+    for (size_t i = 0; i != n_tensors; ++i) {
+      adam_generic(weights[i], gradients[i], mom1[i], mom2[i], sizes[i], clipped);
+    }
+
+    return norm;
+  }
+
+  // Adam update of the given rows of a table. The moments of rows that
+  // were not updated in the preceding steps are decayed lazily, using the
+  // last step in which each row was updated: for a row that was skipped
+  // for k steps, the moments are decayed as if they were updated with a
+  // zero gradient k times. Rows must be unique.
+  template <class U>
+  static void adam_rows_generic(U *weights, const U *gradient, U *mom1, U *mom2,
+                                int *last_step, const int *rows, size_t n_rows, size_t nO,
+                                int step, const AdamParams &params) noexcept {
+    for (size_t i = 0; i != n_rows; ++i) {
+      size_t row = rows[i];
+      double mom1_decay = params.beta1;
+      double mom2_decay = params.beta2;
+      if (last_step[row] + 1 < step) {
+        mom1_decay = std::pow(params.beta1, step - last_step[row]);
+        mom2_decay = std::pow(params.beta2, step - last_step[row]);
+      }
+      adam_decayed(weights + row * nO, gradient + i * nO, mom1 + row * nO, mom2 + row * nO,
+                   nO, params, mom1_decay, mom2_decay);
+      last_step[row] = step;
+    }
+  }
+
+  // Sum of (gradient + L2 * weights)².
+  template <class U>
+  static U adam_gradient_sum_squared(const U *gradient, const U *weights, U L2, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto L2_v = V::broadcast(L2);
+    auto sum_v = V::broadcast(0);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      auto g = V::fma(L2_v, V::load(weights + i), V::load(gradient + i));
+      sum_v = V::fma(g, g, sum_v);
+    }
+
+    U r = V::reduce_add(sum_v);
     if (upper != n) {
-      Array<LOWER_TYPE> array_lower;
-      (array_lower.*f_rest)(a + upper, n - upper);
+      r += Array<LOWER_TYPE>::adam_gradient_sum_squared(gradient + upper, weights + upper, L2,
+                                                         n - upper);
+    }
+
+    return r;
+  }
+
+  // The affine kernel computes output tiles of AFFINE_MR rows by
+  // 2 * V::N columns, which are kept in registers for the whole reduction
+  // over the inputs. The weights are packed into panels of 2 * V::N output
+  // columns, such that each input k is a contiguous row of the panel:
+  //
+  // panel[k * 2 * V::N + c] = W[panel_start + c, k]
+  //
+  // Columns beyond nO are zero-padded, so the tile loop needs no tail.
+  static size_t const AFFINE_MR = 4;
+
+  // Number of input rows for which the packed panels are reused before
+  // moving on to the next row block.
+  static size_t const AFFINE_MC = 64;
+
+  template <class U>
+  static size_t affine_packed_size_generic(size_t nO, size_t nI) noexcept {
+    size_t NR = 2 * TypedVector<T, U>::N;
+    return (nO + NR - 1) / NR * NR * nI;
+  }
+
+  // If row_scale is given, row j of W is multiplied by row_scale[j].
+  template <class U>
+  static void affine_pack_generic(U *packed, const U *W, size_t nO, size_t nI,
+                                  const U *row_scale = nullptr) noexcept {
+    size_t NR = 2 * TypedVector<T, U>::N;
+    for (size_t col = 0; col < nO; col += NR) {
+      U *panel = packed + col * nI;
+      for (size_t k = 0; k != nI; ++k) {
+        for (size_t c = 0; c != NR; ++c) {
+          U w = U(0);
+          if (col + c < nO) {
+            w = W[(col + c) * nI + k];
+            if (row_scale != nullptr) {
+              w *= row_scale[col + c];
+            }
+          }
+          panel[k * NR + c] = w;
+        }
+      }
+    }
+  }
+
+  template <class U>
+  static void affine_generic(U *Y, const U *X, const U *packed, const U *b,
+                             size_t n, size_t nO, size_t nI, Activation activation) noexcept {
+    with_activation(activation, [=](auto act) {
+      affine_rows<decltype(act)>(Y, X, packed, b, n, nO, nI);
+    });
+  }
+
+  template <class F, class U>
+  static void affine_rows(U *Y, const U *X, const U *packed, const U *b,
+                          size_t n, size_t nO, size_t nI) noexcept {
+    size_t const NR = 2 * TypedVector<T, U>::N;
+
+    for (size_t row_block = 0; row_block < n; row_block += AFFINE_MC) {
+      size_t row_block_end = std::min(row_block + AFFINE_MC, n);
+      for (size_t col = 0; col < nO; col += NR) {
+        // Zero-pad the bias of the last panel, like its weights.
+        U bias[NR];
+        for (size_t c = 0; c != NR; ++c) {
+          bias[c] = col + c < nO ? b[col + c] : U(0);
+        }
+
+        const U *panel = packed + col * nI;
+        size_t row = row_block;
+        for (; row + AFFINE_MR <= row_block_end; row += AFFINE_MR) {
+          affine_tile<F, AFFINE_MR>(Y + row * nO, X + row * nI, panel, bias, nO, nI, col);
+        }
+        for (; row != row_block_end; ++row) {
+          affine_tile<F, 1>(Y + row * nO, X + row * nI, panel, bias, nO, nI, col);
+        }
+      }
+    }
+  }
+
+  template <class F, size_t MR, class U>
+  static void affine_tile(U *Y, const U *X, const U *panel, const U *bias,
+                          size_t nO, size_t nI, size_t col) noexcept {
+    typedef TypedVector<T, U> V;
+    size_t const NR = 2 * V::N;
+
+    typename V::TYPE acc0[MR];
+    typename V::TYPE acc1[MR];
+    auto bias0 = V::load(bias);
+    auto bias1 = V::load(bias + V::N);
+    for (size_t r = 0; r != MR; ++r) {
+      acc0[r] = bias0;
+      acc1[r] = bias1;
+    }
+
+    for (size_t k = 0; k != nI; ++k) {
+      auto w0 = V::load(panel + k * NR);
+      auto w1 = V::load(panel + k * NR + V::N);
+      for (size_t r = 0; r != MR; ++r) {
+        auto x = V::broadcast(X[r * nI + k]);
+        acc0[r] = V::fma(x, w0, acc0[r]);
+        acc1[r] = V::fma(x, w1, acc1[r]);
+      }
+    }
+
+    // Epilogue: apply the activation while the tile is in registers.
+    size_t n_cols = std::min(NR, nO - col);
+    for (size_t r = 0; r != MR; ++r) {
+      U *y = Y + r * nO + col;
+      auto y0 = F::template forward<V>(acc0[r]);
+      auto y1 = F::template forward<V>(acc1[r]);
+      if (n_cols == NR) {
+        V::store(y, y0);
+        V::store(y + V::N, y1);
+      } else {
+        U tile[NR];
+        V::store(tile, y0);
+        V::store(tile + V::N, y1);
+        std::copy(tile, tile + n_cols, y);
+      }
+    }
+  }
+
+  // out = a + b, out may alias a or b.
+  template <class U>
+  static void add(U *out, const U *a, const U *b, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      V::store(out + i, V::add(V::load(a + i), V::load(b + i)));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::add(out + upper, a + upper, b + upper, n - upper);
     }
   }
+
+  // Maximum and its first index for each row of X, where NaN counts as
+  // the maximum.
+  template <class U>
+  static void argmax_generic(U *best, int *which, const U *X, size_t n, size_t nO) noexcept {
+    for (size_t i = 0; i != n; ++i) {
+      const U *x = X + i * nO;
+      // V::max does not propagate NaN on every instruction set, so rows
+      // with NaN are searched for their first NaN like in numpy.
+      size_t j = nO;
+      if (row_nonfinite(x, nO)) {
+        j = 0;
+        while (j != nO && x[j] == x[j]) {
+          ++j;
+        }
+      }
+
+      if (j == nO) {
+        U max = row_max(x, nO);
+        j = 0;
+        while (j + 1 < nO && x[j] != max) {
+          ++j;
+        }
+      }
+
+      best[i] = x[j];
+      which[i] = int(j);
+    }
+  }
+
+  // Queries of a block are processed against a tile of keys at a time,
+  // so that the key and value tiles stay in cache.
+  static size_t const ATTENTION_BQ = 16;
+  static size_t const ATTENTION_BK = 64;
+
+  // Scaled dot-product attention softmax(scale * Q K^T) V for each batch
+  // item, attending to the first lengths[b] keys (all keys if lengths is
+  // null). The softmax is computed online: every query keeps the running
+  // maximum and sum of its scores and the output row is rescaled when the
+  // maximum changes, so only one tile of scores exists at a time. Queries
+  // without keys get zero outputs. scale must be positive.
+  template <class U>
+  static void attention_generic(U *out, const U *Q, const U *K, const U *V,
+                                const int *lengths, size_t n_batch, size_t n_q, size_t n_k,
+                                size_t d, size_t d_v, double scale) noexcept {
+    U scores[ATTENTION_BK];
+    U maxes[ATTENTION_BQ];
+    U sums[ATTENTION_BQ];
+
+    for (size_t b = 0; b != n_batch; ++b) {
+      const U *q_b = Q + b * n_q * d;
+      const U *k_b = K + b * n_k * d;
+      const U *v_b = V + b * n_k * d_v;
+      U *out_b = out + b * n_q * d_v;
+      size_t n_keys = n_k;
+      if (lengths != nullptr) {
+        n_keys = std::min(size_t(std::max(lengths[b], 0)), n_k);
+      }
+
+      std::fill(out_b, out_b + n_q * d_v, U(0));
+      for (size_t q0 = 0; q0 < n_q; q0 += ATTENTION_BQ) {
+        size_t bq = std::min(ATTENTION_BQ, n_q - q0);
+        for (size_t k0 = 0; k0 < n_keys; k0 += ATTENTION_BK) {
+          size_t bk = std::min(ATTENTION_BK, n_keys - k0);
+          for (size_t i = 0; i != bq; ++i) {
+            const U *q = q_b + (q0 + i) * d;
+            U *o = out_b + (q0 + i) * d_v;
+            for (size_t j = 0; j != bk; ++j) {
+              scores[j] = dot(q, k_b + (k0 + j) * d, d);
+            }
+
+            U tile_max = row_max(scores, bk);
+            if (k0 == 0) {
+              maxes[i] = tile_max;
+              sums[i] = 0;
+            } else if (tile_max > maxes[i]) {
+              U correction = std::exp(U(scale) * (maxes[i] - tile_max));
+              sums[i] *= correction;
+              Array::scale(o, correction, d_v);
+              maxes[i] = tile_max;
+            }
+
+            sums[i] += softmax_exp(scores, bk, U(scale), maxes[i]);
+            for (size_t j = 0; j != bk; ++j) {
+              axpy(o, scores[j], v_b + (k0 + j) * d_v, d_v);
+            }
+          }
+        }
+
+        if (n_keys != 0) {
+          for (size_t i = 0; i != bq; ++i) {
+            Array::scale(out_b + (q0 + i) * d_v, U(1) / sums[i], d_v);
+          }
+        }
+      }
+    }
+  }
+
+  // y = y + a * x
+  template <class U>
+  static void axpy(U *y, U a, const U *x, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto a_v = V::broadcast(a);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      V::store(y + i, V::fma(a_v, V::load(x + i), V::load(y + i)));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::axpy(y + upper, a, x + upper, n - upper);
+    }
+  }
+
+  template <class U>
+  static U dot(const U *a, const U *b, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto sum_v = V::broadcast(0);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      sum_v = V::fma(V::load(a + i), V::load(b + i), sum_v);
+    }
+
+    U r = V::reduce_add(sum_v);
+    if (upper != n) {
+      r += Array<LOWER_TYPE>::dot(a + upper, b + upper, n - upper);
+    }
+
+    return r;
+  }
+
+  // Y = act(Y + b), with b broadcast over the rows of Y. If D is not
+  // null, it is set to act'(Y + b).
+  template <class U>
+  static void bias_act_generic(U *Y, U *D, const U *b, size_t n, size_t nO,
+                               Activation activation) noexcept {
+    with_activation(activation, [=](auto act) {
+      bias_act_rows<decltype(act)>(Y, D, b, n, nO);
+    });
+  }
+
+  template <class F, class U>
+  static void bias_act_rows(U *Y, U *D, const U *b, size_t n, size_t nO) noexcept {
+    for (size_t i = 0; i != n; ++i) {
+      bias_act_row<F>(Y + i * nO, D == nullptr ? nullptr : D + i * nO, b, nO);
+    }
+  }
+
+  template <class F, class U>
+  static void bias_act_row(U *y, U *d, const U *b, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      auto x = V::add(V::load(y + i), V::load(b + i));
+      auto r = F::template forward<V>(x);
+      V::store(y + i, r);
+      if (d != nullptr) {
+        V::store(d + i, F::template backward<V>(x, r));
+      }
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::template bias_act_row<F>(y + upper, d == nullptr ? nullptr : d + upper,
+                                                  b + upper, n - upper);
+    }
+  }
+
+  // dX = dY * D, where D is the saved activation derivative, while adding
+  // the column sums of dX to db. dX may alias dY.
+  template <class U>
+  static void bias_act_backward_generic(U *dX, U *db, const U *dY, const U *D,
+                                        size_t n, size_t nO) noexcept {
+    for (size_t i = 0; i != n; ++i) {
+      bias_act_backward_row(dX + i * nO, db, dY + i * nO, D + i * nO, nO);
+    }
+  }
+
+  template <class U>
+  static void bias_act_backward_row(U *dx, U *db, const U *dy, const U *d, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      auto r = V::mul(V::load(dy + i), V::load(d + i));
+      V::store(dx + i, r);
+      V::store(db + i, V::add(V::load(db + i), r));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::bias_act_backward_row(dx + upper, db + upper, dy + upper, d + upper, n - upper);
+    }
+  }
+
+  // Rescales the gradient to the norm threshold if its norm is at least
+  // threshold, like thinc's Ops.clip_gradient. Returns the norm.
+  template <class U>
+  static double clip_gradient_generic(U *gradient, size_t n, double threshold) noexcept {
+    double norm = std::sqrt(sum_squared(gradient, n));
+    if (norm >= threshold) {
+      scale(gradient, U(threshold / norm), n);
+    }
+    return norm;
+  }
+
+  template <class U>
+  static void clip_gradient_multi_generic(U *const *gradients, const size_t *sizes,
+                                          size_t n_tensors, double threshold, double *norms) noexcept {
+    for (size_t i = 0; i != n_tensors; ++i) {
+      double norm = clip_gradient_generic(gradients[i], sizes[i], threshold);
+      if (norms != nullptr) {
+        norms[i] = norm;
+      }
+    }
+  }
+
+  // out[i, j] = A[i] · B[j] / (max(||A[i]||, eps) * max(||B[j]||, eps)).
+  // This is a product with B^T, so it reuses the blocked affine kernel: B
+  // is packed into its panels with the rows already normalized and the
+  // output rows are scaled by the inverse norms of A.
+  template <class U>
+  static void cosine_similarity_generic(U *out, const U *A, const U *B, size_t n_a, size_t n_b,
+                                        size_t d, double eps) noexcept {
+    std::vector<U> inv_a(n_a);
+    std::vector<U> inv_b(n_b);
+    inverse_norms(inv_a.data(), A, n_a, d, eps);
+    inverse_norms(inv_b.data(), B, n_b, d, eps);
+
+    std::vector<U> packed(affine_packed_size_generic<U>(n_b, d));
+    affine_pack_generic(packed.data(), B, n_b, d, inv_b.data());
+
+    std::vector<U> zeros(n_b);
+    affine_rows<IdentityActivation>(out, A, packed.data(), zeros.data(), n_a, n_b, d);
+    for (size_t i = 0; i != n_a; ++i) {
+      scale(out + i * n_b, inv_a[i], n_b);
+    }
+  }
+
+  // Number of random numbers that are generated at a time.
+  static size_t const RNG_CHUNK = 256;
+
+  // Element i is dropped when uniform sample offset + i of the seed's
+  // Philox stream is smaller than drop, otherwise it is scaled by
+  // 1 / (1 - drop). If MASK is set, X is filled with the mask instead.
+  template <bool MASK, class U>
+  static void dropout_generic(U *X, size_t n, double drop, uint64_t seed, uint64_t offset) noexcept {
+    uint32_t bits[RNG_CHUNK];
+    U uniform[RNG_CHUNK];
+    U scale = U(1.0 / (1.0 - drop));
+    for (size_t start = 0; start < n; start += RNG_CHUNK) {
+      size_t len = std::min(RNG_CHUNK, n - start);
+      Philox::fill<Vector<T>>(bits, len, offset + start, seed);
+      for (size_t i = 0; i != len; ++i) {
+        uniform[i] = Philox::uniform<U>(bits[i]);
+      }
+      dropout_chunk<MASK>(X + start, uniform, len, U(drop), scale);
+    }
+  }
+
+  template <bool MASK, class U>
+  static void dropout_chunk(U *X, const U *uniform, size_t n, U drop, U scale) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto drop_v = V::broadcast(drop);
+    auto scale_v = V::broadcast(scale);
+    auto zero = V::broadcast(0);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      auto kept = MASK ? scale_v : V::mul(V::load(X + i), scale_v);
+      V::store(X + i, V::select_gt(drop_v, V::load(uniform + i), zero, kept));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::template dropout_chunk<MASK>(X + upper, uniform + upper, n - upper,
+                                                       drop, scale);
+    }
+  }
+
+  // Calls f with an instance of the activation's struct.
+  template <class F>
+  static void with_activation(Activation activation, F f) noexcept {
+    switch (activation) {
+    case ACTIVATION_GELU:
+      f(GeluActivation());
+      break;
+    case ACTIVATION_IDENTITY:
+      f(IdentityActivation());
+      break;
+    case ACTIVATION_RELU:
+      f(ReluActivation());
+      break;
+    case ACTIVATION_SIGMOID:
+      f(SigmoidActivation());
+      break;
+    case ACTIVATION_SWISH:
+      f(SwishActivation());
+      break;
+    case ACTIVATION_TANH:
+      f(TanhActivation());
+      break;
+    }
+  }
+
+  // Normalizes y in place, the moments are stored in mean and var.
+  template <class U>
+  static void layer_norm_row(U *y, U *mean, U *var, const U *G, const U *b,
+                             size_t n, U eps) noexcept {
+    U row_mean = sum(y, n) / n;
+    U row_var = sum_squared_deviation(y, row_mean, n) / n + eps;
+    normalize(y, row_mean, 1 / std::sqrt(row_var), G, b, n);
+    *mean = row_mean;
+    *var = row_var;
+  }
+
+  // Concatenates the sequences, like thinc's Ops.flatten. Empty sequences
+  // are skipped and, if pad is non-zero, every sequence is surrounded by
+  // pad rows of zeros.
+  template <class U>
+  static void flatten_generic(U *out, const U *const *seqs, const int *lengths,
+                              size_t n_seqs, size_t nO, size_t pad) noexcept {
+    for (size_t i = 0; i != n_seqs; ++i) {
+      size_t len = lengths[i] * nO;
+      if (len == 0) {
+        continue;
+      }
+      std::fill(out, out + pad * nO, U(0));
+      out += pad * nO;
+      std::memcpy(out, seqs[i], len * sizeof(U));
+      out += len;
+    }
+    std::fill(out, out + pad * nO, U(0));
+  }
+
+  // Copies the sequences into out, which has n_pad rows per sequence that
+  // are zero beyond the sequence length. The layout of out is
+  // (n_seqs, n_pad, nO), or (n_pad, n_seqs, nO) if time_major is set.
+  template <class U>
+  static void pad_generic(U *out, const U *const *seqs, const int *lengths, size_t n_seqs,
+                          size_t n_pad, size_t nO, bool time_major) noexcept {
+    if (!time_major) {
+      for (size_t i = 0; i != n_seqs; ++i) {
+        size_t len = lengths[i] * nO;
+        std::memcpy(out, seqs[i], len * sizeof(U));
+        std::fill(out + len, out + n_pad * nO, U(0));
+        out += n_pad * nO;
+      }
+      return;
+    }
+
+    // Time-major output is written sequentially, gathering a row from
+    // each sequence per timestep.
+    for (size_t t = 0; t != n_pad; ++t) {
+      for (size_t i = 0; i != n_seqs; ++i) {
+        if (t < size_t(lengths[i])) {
+          std::memcpy(out, seqs[i] + t * nO, nO * sizeof(U));
+        } else {
+          std::fill(out, out + nO, U(0));
+        }
+        out += nO;
+      }
+    }
+  }
+
+  // Inverse of pad_generic: copies the first lengths[i] rows of sequence i
+  // out of padded.
+  template <class U>
+  static void unpad_generic(U *const *seqs, const U *padded, const int *lengths, size_t n_seqs,
+                            size_t n_pad, size_t nO, bool time_major) noexcept {
+    if (!time_major) {
+      for (size_t i = 0; i != n_seqs; ++i) {
+        std::memcpy(seqs[i], padded + i * n_pad * nO, lengths[i] * nO * sizeof(U));
+      }
+      return;
+    }
+
+    for (size_t t = 0; t != n_pad; ++t) {
+      for (size_t i = 0; i != n_seqs; ++i) {
+        if (t < size_t(lengths[i])) {
+          std::memcpy(seqs[i] + t * nO, padded + (t * n_seqs + i) * nO, nO * sizeof(U));
+        }
+      }
+    }
+  }
+
+  // Number of rows ahead of the current row whose table rows are prefetched.
+  static size_t const PREFETCH_ROWS = 4;
+
+  template <bool WRITE, class U>
+  static void prefetch_row(const U *row, size_t n) noexcept {
+    for (size_t i = 0; i < n; i += 64 / sizeof(U)) {
+      __builtin_prefetch(row + i, WRITE);
+    }
+  }
+
+  // Row i of out is the sum of the n_idx table rows indices[i * n_idx + k].
+  template <class U>
+  static void gather_add_generic(U *out, const U *table, const int *indices,
+                                 size_t n, size_t n_idx, size_t nO) noexcept {
+    for (size_t i = 0; i != n; ++i) {
+      if (i + PREFETCH_ROWS < n) {
+        const int *next = indices + (i + PREFETCH_ROWS) * n_idx;
+        for (size_t k = 0; k != n_idx; ++k) {
+          prefetch_row<false>(table + size_t(next[k]) * nO, nO);
+        }
+      }
+      gather_add_row(out + i * nO, table, indices + i * n_idx, n_idx, nO, nO);
+    }
+  }
+
+  template <class U>
+  static void gather_add_row(U *out, const U *table, const int *idx, size_t n_idx,
+                             size_t n, size_t stride) noexcept {
+    typedef TypedVector<T, U> V;
+
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      auto sum = V::broadcast(0);
+      for (size_t k = 0; k != n_idx; ++k) {
+        sum = V::add(sum, V::load(table + size_t(idx[k]) * stride + i));
+      }
+      V::store(out + i, sum);
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::gather_add_row(out + upper, table + upper, idx, n_idx, n - upper, stride);
+    }
+  }
+
+  // Adds row i of values to the n_idx table rows indices[i * n_idx + k].
+  // Negative indices are skipped, like in NumpyOps. Every addition is a
+  // complete read-modify-write of a table row before the next one starts,
+  // so repeated indices accumulate correctly.
+  template <class U>
+  static void scatter_add_generic(U *table, const int *indices, const U *values,
+                                  size_t n, size_t n_idx, size_t nO) noexcept {
+    for (size_t i = 0; i != n; ++i) {
+      if (i + PREFETCH_ROWS < n) {
+        const int *next = indices + (i + PREFETCH_ROWS) * n_idx;
+        for (size_t k = 0; k != n_idx; ++k) {
+          if (next[k] >= 0) {
+            prefetch_row<true>(table + size_t(next[k]) * nO, nO);
+          }
+        }
+      }
+      for (size_t k = 0; k != n_idx; ++k) {
+        int idx = indices[i * n_idx + k];
+        if (idx >= 0) {
+          U *row = table + size_t(idx) * nO;
+          add(row, row, values + i * nO, nO);
+        }
+      }
+    }
+  }
+
+  // Hashes each key into four 32-bit words with MurmurHash3.
+  static void hash_generic(uint32_t *out, const uint64_t *keys, size_t n, uint32_t seed) noexcept {
+    size_t upper = n - (n % Vector<T>::N_DOUBLE);
+    for (size_t i = 0; i != upper; i += Vector<T>::N_DOUBLE) {
+      Vector<T>::murmurhash3(out + i * 4, keys + i, seed);
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::hash_generic(out + upper * 4, keys + upper, n - upper, seed);
+    }
+  }
+
+  // Hashes the n windows of ngram_size consecutive keys, like thinc's
+  // NumpyOps.ngrams. keys must hold n + ngram_size - 1 keys.
+  static void ngrams_generic(uint64_t *out, const uint64_t *keys, size_t n, size_t ngram_size) noexcept {
+    size_t upper = n - (n % Vector<T>::N_DOUBLE);
+    for (size_t i = 0; i != upper; i += Vector<T>::N_DOUBLE) {
+      Vector<T>::murmurhash64a(out + i, keys + i, ngram_size, 0);
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::ngrams_generic(out + upper, keys + upper, n - upper, ngram_size);
+    }
+  }
+
+  // Number of ids that are hashed at a time by hash_embed.
+  static size_t const HASH_CHUNK = 64;
+
+  // HashEmbed lookup: row i of out is the sum of the four table rows given
+  // by the MurmurHash3 words of ids[i] modulo nV. The table rows of each
+  // chunk are prefetched as soon as its ids are hashed. If keys is not
+  // null, the row indices are stored in it for the backward pass.
+  template <class U>
+  static void hash_embed_generic(U *out, int *keys, const U *table, const uint64_t *ids,
+                                 size_t n, size_t nV, size_t nO, uint32_t seed) noexcept {
+    uint32_t hashes[HASH_CHUNK * 4];
+    int rows[HASH_CHUNK * 4];
+    for (size_t start = 0; start < n; start += HASH_CHUNK) {
+      size_t len = std::min(HASH_CHUNK, n - start);
+      hash_generic(hashes, ids + start, len, seed);
+      for (size_t i = 0; i != len * 4; ++i) {
+        rows[i] = int(hashes[i] % nV);
+      }
+      for (size_t i = 0; i != std::min(PREFETCH_ROWS, len) * 4; ++i) {
+        prefetch_row<false>(table + size_t(rows[i]) * nO, nO);
+      }
+
+      gather_add_generic(out + start * nO, table, rows, len, 4, nO);
+      if (keys != nullptr) {
+        std::copy(rows, rows + len * 4, keys + start * 4);
+      }
+    }
+  }
+
+  // Number of rows of which the norms are computed at a time.
+  static size_t const NORM_ROWS = 64;
+
+  // Divides each row of X by max(||x||, eps).
+  template <class U>
+  static void l2_normalize_generic(U *X, size_t n, size_t nO, double eps) noexcept {
+    U inv[NORM_ROWS];
+    for (size_t start = 0; start < n; start += NORM_ROWS) {
+      size_t len = std::min(NORM_ROWS, n - start);
+      inverse_norms(inv, X + start * nO, len, nO, eps);
+      for (size_t i = 0; i != len; ++i) {
+        scale(X + (start + i) * nO, inv[i], nO);
+      }
+    }
+  }
+
+  // out[i] = 1 / max(||X[i]||, eps) for the n rows of X. The squared eps
+  // is kept a normal number, so that it cannot underflow to zero.
+  template <class U>
+  static void inverse_norms(U *out, const U *X, size_t n, size_t nO, double eps) noexcept {
+    for (size_t i = 0; i != n; ++i) {
+      out[i] = sum_squared(X + i * nO, nO);
+    }
+    rsqrt_floor(out, std::max(U(eps * eps), std::numeric_limits<U>::min()), n);
+  }
+
+  // a = 1 / sqrt(max(a, floor)), floor must be positive.
+  template <class U>
+  static void rsqrt_floor(U *a, U floor, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto floor_v = V::broadcast(floor);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      V::store(a + i, V::rsqrt(V::max(V::load(a + i), floor_v)));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::rsqrt_floor(a + upper, floor, n - upper);
+    }
+  }
+
+  // Fused LSTM cell for n hidden units. G holds the pre-activation gates
+  // interleaved per unit as [f, i, o, c], like NumpyOps. The gates are
+  // replaced by their activations, which backward needs together with C.
+  template <class U>
+  static void lstm_gates_generic(U *Y, U *C, U *G, const U *C_prev, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      U *g = G + i * 4;
+      auto hf = V::logistic_cdf(V::load_strided(g, 4));
+      auto hi = V::logistic_cdf(V::load_strided(g + 1, 4));
+      auto ho = V::logistic_cdf(V::load_strided(g + 2, 4));
+      auto hc = V::tanh(V::load_strided(g + 3, 4));
+      V::store_strided(g, 4, hf);
+      V::store_strided(g + 1, 4, hi);
+      V::store_strided(g + 2, 4, ho);
+      V::store_strided(g + 3, 4, hc);
+
+      auto c = V::fma(hf, V::load(C_prev + i), V::mul(hi, hc));
+      V::store(C + i, c);
+      V::store(Y + i, V::mul(V::tanh(c), ho));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::lstm_gates_generic(Y + upper, C + upper, G + upper * 4,
+                                            C_prev + upper, n - upper);
+    }
+  }
+
+  // Backward of lstm_gates_generic, given the activated gates. dC is the
+  // gradient of the cell state from the next timestep.
+  template <class U>
+  static void lstm_gates_backward_generic(U *dG, U *dC_prev, const U *dY, const U *dC,
+                                          const U *G, const U *C, const U *C_prev,
+                                          size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto one = V::broadcast(1.0);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      const U *g = G + i * 4;
+      auto hf = V::load_strided(g, 4);
+      auto hi = V::load_strided(g + 1, 4);
+      auto ho = V::load_strided(g + 2, 4);
+      auto hc = V::load_strided(g + 3, 4);
+
+      auto dy = V::load(dY + i);
+      auto tanh_c = V::tanh(V::load(C + i));
+      auto d_ho = V::mul(dy, tanh_c);
+      auto dc = V::fma(V::mul(dy, ho), V::sub(one, V::mul(tanh_c, tanh_c)), V::load(dC + i));
+      V::store(dC_prev + i, V::mul(dc, hf));
+
+      U *dg = dG + i * 4;
+      auto d_hf = V::mul(dc, V::load(C_prev + i));
+      V::store_strided(dg, 4, V::mul(V::mul(d_hf, hf), V::sub(one, hf)));
+      auto d_hi = V::mul(dc, hc);
+      V::store_strided(dg + 1, 4, V::mul(V::mul(d_hi, hi), V::sub(one, hi)));
+      V::store_strided(dg + 2, 4, V::mul(V::mul(d_ho, ho), V::sub(one, ho)));
+      auto d_hc = V::mul(dc, hi);
+      V::store_strided(dg + 3, 4, V::mul(d_hc, V::sub(one, V::mul(hc, hc))));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::lstm_gates_backward_generic(dG + upper * 4, dC_prev + upper, dY + upper,
+                                                     dC + upper, G + upper * 4, C + upper,
+                                                     C_prev + upper, n - upper);
+    }
+  }
+
+  // Softmax of scale * x over the first lengths[i] elements of row i of X,
+  // the other elements are set to zero. If lengths is null, the softmax is
+  // over complete rows. scale must be positive.
+  template <class U>
+  static void masked_softmax_generic(U *X, const int *lengths, size_t n, size_t nO,
+                                     double scale) noexcept {
+    for (size_t i = 0; i != n; ++i) {
+      U *x = X + i * nO;
+      size_t len = nO;
+      if (lengths != nullptr) {
+        len = std::min(size_t(std::max(lengths[i], 0)), nO);
+      }
+
+      if (len != 0) {
+        U sum = softmax_exp(x, len, U(scale), row_max(x, len));
+        Array::scale(x, U(1) / sum, len);
+      }
+      std::fill(x + len, x + nO, U(0));
+    }
+  }
+
+  // Maximum of a, n must be at least 1.
+  template <class U>
+  static U row_max(const U *a, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    U r = a[0];
+    size_t upper = n - (n % V::N);
+    if (upper != 0) {
+      auto max_v = V::load(a);
+      for (size_t i = V::N; i != upper; i += V::N) {
+        max_v = V::max(max_v, V::load(a + i));
+      }
+      r = V::reduce_max(max_v);
+    }
+
+    if (upper != n) {
+      r = std::max(r, Array<LOWER_TYPE>::row_max(a + upper, n - upper));
+    }
+
+    return r;
+  }
+
+  // Whether a contains NaN or infinite values, which are the values for
+  // which a - a is NaN.
+  template <class U>
+  static bool row_nonfinite(const U *a, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    size_t upper = n - (n % V::N);
+    if (upper != 0) {
+      auto sum_v = V::broadcast(0);
+      for (size_t i = 0; i != upper; i += V::N) {
+        auto a_v = V::load(a + i);
+        sum_v = V::add(sum_v, V::sub(a_v, a_v));
+      }
+      U sum = V::reduce_add(sum_v);
+      if (sum != sum) {
+        return true;
+      }
+    }
+
+    return upper != n && Array<LOWER_TYPE>::row_nonfinite(a + upper, n - upper);
+  }
+
+  // a = exp(scale * (a - shift)), returns the sum of the results.
+  template <class U>
+  static U softmax_exp(U *a, size_t n, U scale, U shift) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto scale_v = V::broadcast(scale);
+    auto shift_v = V::broadcast(shift);
+    auto sum_v = V::broadcast(0);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      auto r = V::exp(V::mul(V::sub(V::load(a + i), shift_v), scale_v));
+      V::store(a + i, r);
+      sum_v = V::add(sum_v, r);
+    }
+
+    U r = V::reduce_add(sum_v);
+    if (upper != n) {
+      r += Array<LOWER_TYPE>::softmax_exp(a + upper, n - upper, scale, shift);
+    }
+
+    return r;
+  }
+
+  // Vectorizes over outputs, each lane tracks the best piece of one
+  // output. Ties resolve to the first piece, like thinc's maxout.
+  template <class U>
+  static void maxout_generic(U *best, int *which, const U *X, size_t n, size_t P) noexcept {
+    typedef TypedVector<T, U> V;
+
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      const U *x = X + i * P;
+      auto best_v = V::load_strided(x, P);
+      auto which_v = V::broadcast(0);
+      for (size_t p = 1; p < P; ++p) {
+        auto piece = V::load_strided(x + p, P);
+        which_v = V::select_gt(piece, best_v, V::broadcast(p), which_v);
+        best_v = V::select_gt(piece, best_v, piece, best_v);
+      }
+
+      U which_lanes[V::N];
+      V::store(best + i, best_v);
+      V::store(which_lanes, which_v);
+      for (size_t j = 0; j != V::N; ++j) {
+        which[i + j] = static_cast<int>(which_lanes[j]);
+      }
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::maxout_generic(best + upper, which + upper,
+                                        X + upper * P, n - upper, P);
+    }
+  }
+
+  template <class U>
+  static void maxout_layer_norm_generic(U *Y, int *which, U *mean, U *var,
+                                        const U *X, const U *G, const U *b,
+                                        size_t n, size_t nO, size_t nP, U eps) noexcept {
+    for (size_t i = 0; i != n; ++i) {
+      // The maxout row is still in L1 when computing the moments and
+      // normalizing it.
+      U *y = Y + i * nO;
+      maxout_generic(y, which + i * nO, X + i * nO * nP, nO, nP);
+      layer_norm_row(y, mean + i, var + i, G, b, nO, eps);
+    }
+  }
+
+  // Writes every element of dX once, so it does not need to be zeroed.
+  template <class U>
+  static void maxout_backward_generic(U *dX, const U *dY, const int *which,
+                                      size_t n, size_t P) noexcept {
+    for (size_t i = 0; i != n; ++i) {
+      U *dx = dX + i * P;
+      for (size_t p = 0; p != P; ++p) {
+        dx[p] = static_cast<int>(p) == which[i] ? dY[i] : U(0);
+      }
+    }
+  }
+
+  // Sinusoidal position encoding, like thinc's position_encode:
+  //
+  // out[pos, d] = sin(pos / period^(2d / D))
+  // out[pos, d + 1] = cos(pos / period^(2d / D))
+  //
+  // for even d. If D is odd, the last column is the sine of the last pair's
+  // angle. Each row is computed over the columns with a single sincos per
+  // vector, selecting the sine or cosine by the column's parity.
+  template <class U>
+  static void position_encode_generic(U *out, size_t N, size_t D, double period) noexcept {
+    std::vector<U> freq(D);
+    std::vector<U> odd(D);
+    for (size_t j = 0; j != D; ++j) {
+      size_t d = j - j % 2;
+      if (d + 1 >= D && D > 1) {
+        // Unpaired last column.
+        d -= 2;
+      }
+      freq[j] = U(std::pow(period, -2.0 * d / D));
+      odd[j] = j % 2;
+    }
+
+    for (size_t pos = 0; pos != N; ++pos) {
+      position_encode_row(out + pos * D, freq.data(), odd.data(), U(pos), D);
+    }
+  }
+
+  template <class U>
+  static void position_encode_row(U *out, const U *freq, const U *odd, U pos, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto pos_v = V::broadcast(pos);
+    auto half = V::broadcast(0.5);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      typename V::TYPE s, c;
+      V::sincos(V::mul(pos_v, V::load(freq + i)), &s, &c);
+      V::store(out + i, V::select_gt(V::load(odd + i), half, c, s));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::position_encode_row(out + upper, freq + upper, odd + upper, pos, n - upper);
+    }
+  }
+
+  // Box-Muller transform. Sample i of the stream is computed from random
+  // numbers 2p and 2p + 1 with p = i / 2, taking the cosine for even and
+  // the sine for odd i, so that a sample only depends on the seed and its
+  // position in the stream.
+  template <class U>
+  static void random_normal_generic(U *out, size_t n, double mean, double std, uint64_t seed,
+                                    uint64_t offset) noexcept {
+    size_t const PAIRS = RNG_CHUNK / 2;
+    uint32_t bits[RNG_CHUNK];
+    U u1[PAIRS], u2[PAIRS], c[PAIRS], s[PAIRS];
+
+    uint64_t end = offset + n;
+    for (uint64_t pair = offset / 2; 2 * pair < end; pair += PAIRS) {
+      size_t n_pairs = std::min<uint64_t>(PAIRS, (end + 1) / 2 - pair);
+      Philox::fill<Vector<T>>(bits, 2 * n_pairs, 2 * pair, seed);
+      for (size_t j = 0; j != n_pairs; ++j) {
+        u1[j] = Philox::uniform_nonzero<U>(bits[2 * j]);
+        u2[j] = Philox::uniform<U>(bits[2 * j + 1]);
+      }
+
+      box_muller(c, s, u1, u2, U(std), n_pairs);
+
+      for (size_t j = 0; j != n_pairs; ++j) {
+        uint64_t i = 2 * (pair + j);
+        if (i >= offset && i < end) {
+          out[i - offset] = U(mean) + c[j];
+        }
+        if (i + 1 >= offset && i + 1 < end) {
+          out[i + 1 - offset] = U(mean) + s[j];
+        }
+      }
+    }
+  }
+
+  // c = std * r * cos(theta), s = std * r * sin(theta),
+  // with r = sqrt(-2 log(u1)) and theta = 2 pi u2.
+  template <class U>
+  static void box_muller(U *c, U *s, const U *u1, const U *u2, U std, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto minus_two = V::broadcast(-2);
+    auto two_pi = V::broadcast(6.283185307179586);
+    auto std_v = V::broadcast(std);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      auto r = V::mul(std_v, V::sqrt(V::mul(minus_two, V::log(V::load(u1 + i)))));
+      typename V::TYPE sin_theta, cos_theta;
+      V::sincos(V::mul(two_pi, V::load(u2 + i)), &sin_theta, &cos_theta);
+      V::store(c + i, V::mul(r, cos_theta));
+      V::store(s + i, V::mul(r, sin_theta));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::box_muller(c + upper, s + upper, u1 + upper, u2 + upper, std, n - upper);
+    }
+  }
+
+  template <class U>
+  static void random_uniform_generic(U *out, size_t n, double low, double high, uint64_t seed,
+                                     uint64_t offset) noexcept {
+    uint32_t bits[RNG_CHUNK];
+    for (size_t start = 0; start < n; start += RNG_CHUNK) {
+      size_t len = std::min(RNG_CHUNK, n - start);
+      Philox::fill<Vector<T>>(bits, len, offset + start, seed);
+      for (size_t i = 0; i != len; ++i) {
+        out[start + i] = Philox::uniform<U>(bits[i]);
+      }
+      scale_shift(out + start, U(high - low), U(low), len);
+    }
+  }
+
+  // Replaces each row of X by exp((X - max) / temperature) and draws an
+  // index from it with random number offset + i for row i. With top_p < 1
+  // only the most probable entries that together have mass top_p are kept,
+  // as in nucleus sampling. Entries tied with the least probable kept entry
+  // are kept as well.
+  template <class U>
+  static void sample_generic(int *out, U *X, size_t n, size_t nO, double temperature,
+                             double top_p, uint64_t seed, uint64_t offset) noexcept {
+    uint32_t bits[RNG_CHUNK];
+    for (size_t i = 0; i != n; ++i) {
+      U *p = X + i * nO;
+      U mass = softmax_exp(p, nO, U(1.0 / temperature), row_max(p, nO));
+      U threshold = 0;
+      if (top_p < 1) {
+        threshold = nucleus_threshold(p, nO, U(top_p) * mass, mass);
+      }
+
+      if (i % RNG_CHUNK == 0) {
+        Philox::fill<Vector<T>>(bits, std::min(RNG_CHUNK, n - i), offset + i, seed);
+      }
+      U u = Philox::uniform<U>(bits[i % RNG_CHUNK]);
+      out[i] = int(sample_index(p, nO, threshold, u * mass));
+    }
+  }
+
+  // Largest entry t of p such that the entries of p that are at least t
+  // have a mass of at least target, found by bisecting the candidates.
+  // Every step removes at least one candidate. On return, mass is the mass
+  // of the entries that are at least t.
+  template <class U>
+  static U nucleus_threshold(const U *p, size_t n, U target, U &mass) noexcept {
+    U lo = 0;
+    U hi = row_max(p, n);
+    while (lo < hi) {
+      U pivot = lo + (hi - lo) / 2;
+      if (!(pivot > lo)) {
+        pivot = hi;
+      }
+
+      U above_min, below_max;
+      U pivot_mass = nucleus_mass(p, n, pivot, above_min, below_max);
+      if (pivot_mass >= target) {
+        lo = above_min;
+        mass = pivot_mass;
+      } else {
+        hi = below_max;
+      }
+    }
+
+    return lo;
+  }
+
+  // Mass of the entries of p in [0, 1] that are at least pivot. Also gives
+  // the smallest of these entries and the largest entry below pivot, -1 if
+  // there is none.
+  template <class U>
+  static U nucleus_mass(const U *p, size_t n, U pivot, U &above_min, U &below_max) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto pivot_v = V::broadcast(pivot);
+    auto zero = V::broadcast(0);
+    auto none = V::broadcast(-2);
+    auto mass_v = zero;
+    auto neg_min_v = none;
+    auto max_v = none;
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      auto x = V::load(p + i);
+      mass_v = V::add(mass_v, V::select_gt(pivot_v, x, zero, x));
+      neg_min_v = V::max(neg_min_v, V::select_gt(pivot_v, x, none, V::sub(zero, x)));
+      max_v = V::max(max_v, V::select_gt(pivot_v, x, x, none));
+    }
+
+    U mass = V::reduce_add(mass_v);
+    above_min = -V::reduce_max(neg_min_v);
+    below_max = std::max(U(-1), U(V::reduce_max(max_v)));
+    if (upper != n) {
+      U tail_min, tail_max;
+      mass += Array<LOWER_TYPE>::nucleus_mass(p + upper, n - upper, pivot, tail_min, tail_max);
+      above_min = std::min(above_min, tail_min);
+      below_max = std::max(below_max, tail_max);
+    }
+
+    return mass;
+  }
+
+  // Index at which the cumulative mass of the entries of p that are at
+  // least threshold exceeds u. Vectors that do not reach u are skipped
+  // whole. If rounding leaves u unreached, the last such entry is used.
+  template <class U>
+  static size_t sample_index(const U *p, size_t n, U threshold, U u) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto threshold_v = V::broadcast(threshold);
+    auto zero = V::broadcast(0);
+    U cumulative = 0;
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i < n; i += V::N) {
+      if (i != upper) {
+        auto x = V::load(p + i);
+        U block = V::reduce_add(V::select_gt(threshold_v, x, zero, x));
+        if (!(cumulative + block > u)) {
+          cumulative += block;
+          continue;
+        }
+      }
+
+      for (size_t j = i; j != std::min(i + V::N, n); ++j) {
+        if (!(p[j] < threshold)) {
+          cumulative += p[j];
+          if (cumulative > u) {
+            return j;
+          }
+        }
+      }
+    }
+
+    size_t j = n - 1;
+    while (j != 0 && (p[j] < threshold || p[j] == 0)) {
+      --j;
+    }
+    return j;
+  }
+
+  // a = a * scale + shift
+  template <class U>
+  static void scale_shift(U *a, U scale, U shift, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto scale_v = V::broadcast(scale);
+    auto shift_v = V::broadcast(shift);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      V::store(a + i, V::fma(V::load(a + i), scale_v, shift_v));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::scale_shift(a + upper, scale, shift, n - upper);
+    }
+  }
+
+  template <class U>
+  static void residual_layer_norm_generic(U *Y, U *S, U *mean, U *var,
+                                          const U *X, const U *R, const U *G, const U *b,
+                                          size_t n, size_t nO, U eps) noexcept {
+    for (size_t i = 0; i != n; ++i) {
+      U *y = Y + i * nO;
+      add(y, X + i * nO, R + i * nO, nO);
+      if (S != nullptr) {
+        std::memcpy(S + i * nO, y, nO * sizeof(U));
+      }
+      layer_norm_row(y, mean + i, var + i, G, b, nO, eps);
+    }
+  }
+
+  // a *= s
+  template <class U>
+  static void scale(U *a, U s, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto s_v = V::broadcast(s);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      V::store(a + i, V::mul(V::load(a + i), s_v));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::scale(a + upper, s, n - upper);
+    }
+  }
+
+  // y = (y - mean) * inv_std * G + b
+  template <class U>
+  static void normalize(U *y, U mean, U inv_std, const U *G, const U *b, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto mean_v = V::broadcast(mean);
+    auto inv_std_v = V::broadcast(inv_std);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      auto r = V::mul(V::sub(V::load(y + i), mean_v), inv_std_v);
+      V::store(y + i, V::add(V::mul(r, V::load(G + i)), V::load(b + i)));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::normalize(y + upper, mean, inv_std, G + upper, b + upper, n - upper);
+    }
+  }
+
+  // The window of position i is [i - nW, i + nW] clipped to the boundaries
+  // of its sequence. Since the clipped window is contiguous in both the
+  // sequence and the output row, a row is a single copy plus zero padding.
+  template <class U>
+  static void seq2col_generic(U *cols, const U *seq, const int *lengths,
+                              size_t n_lengths, size_t nW, size_t nI) noexcept {
+    size_t nF = 2 * nW + 1;
+    size_t seq_start = 0;
+    for (size_t s = 0; s != n_lengths; ++s) {
+      size_t seq_end = seq_start + lengths[s];
+      for (size_t i = seq_start; i != seq_end; ++i) {
+        size_t win_start = i - seq_start < nW ? seq_start : i - nW;
+        size_t win_end = std::min(i + nW + 1, seq_end);
+        size_t n_before = (win_start + nW - i) * nI;
+        size_t n_window = (win_end - win_start) * nI;
+
+        U *row = cols + i * nF * nI;
+        std::fill(row, row + n_before, U(0));
+        std::memcpy(row + n_before, seq + win_start * nI, n_window * sizeof(U));
+        std::fill(row + n_before + n_window, row + nF * nI, U(0));
+      }
+      seq_start = seq_end;
+    }
+  }
+
+  template <class U>
+  static void seq2col_backward_generic(U *dX, const U *dY, const int *lengths,
+                                       size_t n_lengths, size_t nW, size_t nI) noexcept {
+    size_t nF = 2 * nW + 1;
+    size_t seq_start = 0;
+    for (size_t s = 0; s != n_lengths; ++s) {
+      size_t seq_end = seq_start + lengths[s];
+      std::fill(dX + seq_start * nI, dX + seq_end * nI, U(0));
+      for (size_t i = seq_start; i != seq_end; ++i) {
+        size_t win_start = i - seq_start < nW ? seq_start : i - nW;
+        size_t win_end = std::min(i + nW + 1, seq_end);
+        size_t n_before = (win_start + nW - i) * nI;
+        size_t n_window = (win_end - win_start) * nI;
+
+        U *dx = dX + win_start * nI;
+        add(dx, dx, dY + i * nF * nI + n_before, n_window);
+      }
+      seq_start = seq_end;
+    }
+  }
+
+  // The k largest values of each row of X with their indices, in
+  // descending order with ties in index order. NaN counts as the largest
+  // value, like in argmax. A vector of the row is only inspected
+  // element-wise when its maximum can enter the current top k, which
+  // V::reduce_max cannot tell for rows with NaN.
+  template <class U>
+  static void top_k_generic(U *values, int *indices, const U *X, size_t n, size_t nO,
+                            size_t k) noexcept {
+    typedef TypedVector<T, U> V;
+
+    size_t upper = nO - (nO % V::N);
+    for (size_t i = 0; i != n; ++i) {
+      const U *x = X + i * nO;
+      U *row_values = values + i * k;
+      int *row_indices = indices + i * k;
+      size_t count = 0;
+      bool skip = !row_nonfinite(x, nO);
+      for (size_t j = 0; j != upper; j += V::N) {
+        if (skip && count == k && !(V::reduce_max(V::load(x + j)) > row_values[k - 1])) {
+          continue;
+        }
+        for (size_t l = j; l != j + V::N; ++l) {
+          top_k_insert(row_values, row_indices, count, k, x[l], int(l));
+        }
+      }
+      for (size_t j = upper; j != nO; ++j) {
+        top_k_insert(row_values, row_indices, count, k, x[j], int(j));
+      }
+    }
+  }
+
+  // Inserts v into the count sorted values, of which at most k are kept.
+  template <class U>
+  static void top_k_insert(U *values, int *indices, size_t &count, size_t k, U v, int index) noexcept {
+    if (count == k) {
+      if (!top_k_greater(v, values[k - 1])) {
+        return;
+      }
+    } else {
+      ++count;
+    }
+
+    size_t j = count - 1;
+    while (j != 0 && top_k_greater(v, values[j - 1])) {
+      values[j] = values[j - 1];
+      indices[j] = indices[j - 1];
+      --j;
+    }
+    values[j] = v;
+    indices[j] = index;
+  }
+
+  // Whether a comes before b in the top k, where NaN is larger than any
+  // other value and equal to NaN.
+  template <class U>
+  static bool top_k_greater(U a, U b) noexcept {
+    if (a != a) {
+      return b == b;
+    }
+    return a > b;
+  }
+
+  // ema += (1 - decay) * (weights - ema)
+  template <class U>
+  static void update_averages_generic(U *ema, const U *weights, size_t n, double decay) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto rate = V::broadcast(1.0 - decay);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      auto e = V::load(ema + i);
+      V::store(ema + i, V::fma(rate, V::sub(V::load(weights + i), e), e));
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE>::update_averages_generic(ema + upper, weights + upper, n - upper, decay);
+    }
+  }
+
+  template <class F, class G>
+  static void apply_elementwise(F f, G f_rest, float *a, size_t n) {
+    size_t upper = n - (n % N_FLOAT);
+    for (float *cur = a; cur != a + upper; cur += N_FLOAT) {
+      Vector<T>::with_load_store(f, cur);
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE> array_lower;
+      (array_lower.*f_rest)(a + upper, n - upper);
+    }
+  }
+
+  template <class F, class G>
+  static void apply_elementwise(F f, G f_rest, double *a, size_t n) {
+    size_t upper = n - (n % N_DOUBLE);
+    for (double *cur = a; cur != a + upper; cur += N_DOUBLE) {
+      Vector<T>::with_load_store(f, cur);
+    }
+
+    if (upper != n) {
+      Array<LOWER_TYPE> array_lower;
+      (array_lower.*f_rest)(a + upper, n - upper);
+    }
+  }
+
+  template <class U>
+  static U sum(const U *a, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto sum_v = V::broadcast(0);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      sum_v = V::add(sum_v, V::load(a + i));
+    }
+
+    U r = V::reduce_add(sum_v);
+    if (upper != n) {
+      r += Array<LOWER_TYPE>::sum(a + upper, n - upper);
+    }
+
+    return r;
+  }
+
+  // Uses four accumulators to hide the latency of the additions.
+  template <class U>
+  static U sum_squared(const U *a, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto sum0 = V::broadcast(0);
+    auto sum1 = V::broadcast(0);
+    auto sum2 = V::broadcast(0);
+    auto sum3 = V::broadcast(0);
+    size_t upper_unrolled = n - (n % (4 * V::N));
+    for (size_t i = 0; i != upper_unrolled; i += 4 * V::N) {
+      auto a0 = V::load(a + i);
+      auto a1 = V::load(a + i + V::N);
+      auto a2 = V::load(a + i + 2 * V::N);
+      auto a3 = V::load(a + i + 3 * V::N);
+      sum0 = V::fma(a0, a0, sum0);
+      sum1 = V::fma(a1, a1, sum1);
+      sum2 = V::fma(a2, a2, sum2);
+      sum3 = V::fma(a3, a3, sum3);
+    }
+
+    size_t upper = n - (n % V::N);
+    for (size_t i = upper_unrolled; i != upper; i += V::N) {
+      auto a0 = V::load(a + i);
+      sum0 = V::fma(a0, a0, sum0);
+    }
+
+    U r = V::reduce_add(V::add(V::add(sum0, sum1), V::add(sum2, sum3)));
+    if (upper != n) {
+      r += Array<LOWER_TYPE>::sum_squared(a + upper, n - upper);
+    }
+
+    return r;
+  }
+
+  template <class U>
+  static U sum_squared_deviation(const U *a, U mean, size_t n) noexcept {
+    typedef TypedVector<T, U> V;
+
+    auto mean_v = V::broadcast(mean);
+    auto sum_v = V::broadcast(0);
+    size_t upper = n - (n % V::N);
+    for (size_t i = 0; i != upper; i += V::N) {
+      auto dev = V::sub(V::load(a + i), mean_v);
+      sum_v = V::add(sum_v, V::mul(dev, dev));
+    }
+
+    U r = V::reduce_add(sum_v);
+    if (upper != n) {
+      r += Array<LOWER_TYPE>::sum_squared_deviation(a + upper, mean, n - upper);
+    }
+
+    return r;
+  }
 };
 
 #endif // ARRAY_IMPL_H_
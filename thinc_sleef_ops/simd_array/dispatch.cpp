@@ -31,6 +31,9 @@ std::unordered_set<InstructionSet> instruction_sets() {
   if (cpu_id.flags[CPU_FEATURE_AVX])
     features.insert(INSTRUCTION_SET_AVX);
 
+  if (cpu_id.flags[CPU_FEATURE_AVX2])
+    features.insert(INSTRUCTION_SET_AVX2);
+
   if (cpu_id.flags[CPU_FEATURE_AVX512F])
     features.insert(INSTRUCTION_SET_AVX512F);
 
@@ -59,22 +62,29 @@ std::unordered_set<InstructionSet> instruction_sets() {
 
 #endif
 
-std::unique_ptr<ArrayBase> create_array() {
+InstructionSet best_instruction_set() {
   auto features = instruction_sets();
 
   if (features.find(INSTRUCTION_SET_AVX512F) != features.end())
-    return create_array_for_instruction_set(INSTRUCTION_SET_AVX512F);
+    return INSTRUCTION_SET_AVX512F;
+
+  if (features.find(INSTRUCTION_SET_AVX2) != features.end())
+    return INSTRUCTION_SET_AVX2;
 
   if (features.find(INSTRUCTION_SET_AVX) != features.end())
-    return create_array_for_instruction_set(INSTRUCTION_SET_AVX);
+    return INSTRUCTION_SET_AVX;
 
   if (features.find(INSTRUCTION_SET_NEON) != features.end())
-    return create_array_for_instruction_set(INSTRUCTION_SET_NEON);
+    return INSTRUCTION_SET_NEON;
 
   if (features.find(INSTRUCTION_SET_SSE2) != features.end())
-    return create_array_for_instruction_set(INSTRUCTION_SET_SSE2);
+    return INSTRUCTION_SET_SSE2;
+
+  return INSTRUCTION_SET_SCALAR;
+}
 
-  return create_array_for_instruction_set(INSTRUCTION_SET_SCALAR);
+std::unique_ptr<ArrayBase> create_array() {
+  return create_array_for_instruction_set(best_instruction_set());
 }
 
 std::unique_ptr<ArrayBase> create_array_for_instruction_set(InstructionSet feature) {
@@ -84,6 +94,11 @@ std::unique_ptr<ArrayBase> create_array_for_instruction_set(InstructionSet featu
       return std::unique_ptr<ArrayBase>(new Array<AVX>());
     #endif
 
+    #if defined(COMPILER_SUPPORTS_AVX2)
+    case INSTRUCTION_SET_AVX2:
+      return std::unique_ptr<ArrayBase>(new Array<AVX2>());
+    #endif
+
     #if defined(COMPILER_SUPPORTS_AVX512F)
     case INSTRUCTION_SET_AVX512F:
       return std::unique_ptr<ArrayBase>(new Array<AVX512>());
@@ -11,6 +11,7 @@
 // Note: keep in sync with sleef_ops.pxd
 enum InstructionSet {
   INSTRUCTION_SET_AVX,
+  INSTRUCTION_SET_AVX2,
   INSTRUCTION_SET_AVX512F,
   INSTRUCTION_SET_NEON,
   INSTRUCTION_SET_SCALAR,
@@ -23,6 +24,11 @@ enum InstructionSet {
  */
 std::unordered_set<InstructionSet> instruction_sets();
 
+/**
+ * The best supported instruction set.
+ */
+InstructionSet best_instruction_set();
+
 /**
  * Create an array for the best supported instruction set.
  */
@@ -0,0 +1,50 @@
+#ifndef PHILOX_HH
+#define PHILOX_HH
+
+#include <cstddef>
+#include <cstdint>
+
+// Philox4x32-10 counter-based random number generator (Salmon et al.,
+// 2011). Random number i of a stream is word i % 4 of the block with
+// counter i / 4, so any range of the stream can be regenerated from the
+// seed and its offset, independent of the instruction set. The blocks
+// themselves are computed by Vector<T>::philox.
+struct Philox {
+  // Fills out with numbers offset, ..., offset + n - 1 of the stream,
+  // computing V::N_DOUBLE blocks at a time with V::philox.
+  template <class V>
+  static void fill(uint32_t *out, size_t n, uint64_t offset, uint64_t seed) noexcept {
+    size_t const WORDS = 4 * V::N_DOUBLE;
+    uint32_t words[WORDS];
+    size_t i = 0;
+    while (i != n) {
+      uint64_t index = offset + i;
+      size_t word = index % 4;
+      if (word == 0 && n - i >= WORDS) {
+        V::philox(out + i, index / 4, seed);
+        i += WORDS;
+        continue;
+      }
+
+      V::philox(words, index / 4, seed);
+      for (; word != WORDS && i != n; ++word, ++i) {
+        out[i] = words[word];
+      }
+    }
+  }
+
+  // Converts a random number to a uniform sample in [0, 1), using 24 bits
+  // so that float and double samples are identical.
+  template <class U>
+  static U uniform(uint32_t bits) noexcept {
+    return U(bits >> 8) * U(1.0 / (1 << 24));
+  }
+
+  // Like uniform, but samples from (0, 1].
+  template <class U>
+  static U uniform_nonzero(uint32_t bits) noexcept {
+    return U((bits >> 8) + 1) * U(1.0 / (1 << 24));
+  }
+};
+
+#endif // PHILOX_HH
@@ -4,10 +4,12 @@
 #include <functional>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
 
 #include <sleef.h>
 
 struct AVX {};
+struct AVX2 {};
 struct AVX512 {};
 struct NEON {};
 struct SSE {};
@@ -114,6 +116,14 @@ struct Vector<Scalar> {
     return a + b;
   }
 
+  static DOUBLE_TYPE broadcast(double a) noexcept {
+    return a;
+  }
+
+  static FLOAT_TYPE broadcastf(float a) noexcept {
+    return a;
+  }
+
   static DOUBLE_TYPE div(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
     return a / b;
   }
@@ -138,6 +148,38 @@ struct Vector<Scalar> {
     return std::exp(a);
   }
 
+  static DOUBLE_TYPE fma(DOUBLE_TYPE a, DOUBLE_TYPE b, DOUBLE_TYPE c) noexcept {
+    return a * b + c;
+  }
+
+  static FLOAT_TYPE fmaf(FLOAT_TYPE a, FLOAT_TYPE b, FLOAT_TYPE c) noexcept {
+    return a * b + c;
+  }
+
+  static DOUBLE_TYPE load(const double *a) noexcept {
+    return *a;
+  }
+
+  static DOUBLE_TYPE load_strided(const double *a, size_t) noexcept {
+    return *a;
+  }
+
+  static FLOAT_TYPE load_stridedf(const float *a, size_t) noexcept {
+    return *a;
+  }
+
+  static FLOAT_TYPE loadf(const float *a) noexcept {
+    return *a;
+  }
+
+  static DOUBLE_TYPE log(DOUBLE_TYPE a) noexcept {
+    return std::log(a);
+  }
+
+  static FLOAT_TYPE logf(FLOAT_TYPE a) noexcept {
+    return std::log(a);
+  }
+
   static DOUBLE_TYPE logistic_cdf(DOUBLE_TYPE a) {
     return generic_logistic_cdf<Scalar>(a);
   }
@@ -154,6 +196,14 @@ struct Vector<Scalar> {
     return generic_logistic_pdff<Scalar>(a);
   }
 
+  static DOUBLE_TYPE max(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
+    return a > b ? a : b;
+  }
+
+  static FLOAT_TYPE maxf(FLOAT_TYPE a, FLOAT_TYPE b) noexcept {
+    return a > b ? a : b;
+  }
+
   static DOUBLE_TYPE mul(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
     return a * b;
   }
@@ -170,6 +220,57 @@ struct Vector<Scalar> {
     return a * b;
   }
 
+  // MurmurHash3_x64_128 of a 64-bit key, written as four 32-bit words like
+  // thinc's NumpyOps.hash.
+  static void murmurhash3(uint32_t *out, const uint64_t *keys, uint32_t seed) noexcept {
+    uint64_t h1 = *keys * 0x87c37b91114253d5ull;
+    h1 = (h1 << 31) | (h1 >> 33);
+    h1 *= 0x4cf5ad432745937full;
+    h1 ^= seed;
+    h1 ^= 8;
+    uint64_t h2 = seed;
+    h2 ^= 8;
+    h1 += h2;
+    h2 += h1;
+    h1 = murmurhash3_fmix(h1);
+    h2 = murmurhash3_fmix(h2);
+    h1 += h2;
+    h2 += h1;
+
+    out[0] = uint32_t(h1);
+    out[1] = uint32_t(h1 >> 32);
+    out[2] = uint32_t(h2);
+    out[3] = uint32_t(h2 >> 32);
+  }
+
+  static uint64_t murmurhash3_fmix(uint64_t h) noexcept {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+  }
+
+  // MurmurHash64A of the n keys starting at keys, like the hash64 function
+  // that thinc's NumpyOps.ngrams uses.
+  static void murmurhash64a(uint64_t *out, const uint64_t *keys, size_t n, uint64_t seed) noexcept {
+    uint64_t const m = 0xc6a4a7935bd1e995ull;
+    uint64_t h = seed ^ (n * sizeof(uint64_t) * m);
+    for (size_t i = 0; i != n; ++i) {
+      uint64_t k = keys[i] * m;
+      k ^= k >> 47;
+      k *= m;
+      h ^= k;
+      h *= m;
+    }
+
+    h ^= h >> 47;
+    h *= m;
+    h ^= h >> 47;
+    *out = h;
+  }
+
   static DOUBLE_TYPE neg(DOUBLE_TYPE a) noexcept {
     return -a;
   }
@@ -194,6 +295,32 @@ struct Vector<Scalar> {
     return generic_normal_pdff<Scalar>(a);
   }
 
+  // Philox4x32-10 block with the given counter (Salmon et al., 2011).
+  static void philox(uint32_t *out, uint64_t counter, uint64_t seed) noexcept {
+    uint32_t c0 = uint32_t(counter);
+    uint32_t c1 = uint32_t(counter >> 32);
+    uint32_t c2 = 0;
+    uint32_t c3 = 0;
+    uint32_t k0 = uint32_t(seed);
+    uint32_t k1 = uint32_t(seed >> 32);
+
+    for (int round = 0; round != 10; ++round) {
+      uint64_t p0 = uint64_t(0xD2511F53) * c0;
+      uint64_t p1 = uint64_t(0xCD9E8D57) * c2;
+      c0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+      c1 = uint32_t(p1);
+      c2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+      c3 = uint32_t(p0);
+      k0 += 0x9E3779B9;
+      k1 += 0xBB67AE85;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+  }
+
   static DOUBLE_TYPE recip(DOUBLE_TYPE a) noexcept {
     return 1.0 / a;
   }
@@ -202,6 +329,80 @@ struct Vector<Scalar> {
     return 1.0 / a;
   }
 
+  static double reduce_add(DOUBLE_TYPE a) noexcept {
+    return a;
+  }
+
+  static float reduce_addf(FLOAT_TYPE a) noexcept {
+    return a;
+  }
+
+  static double reduce_max(DOUBLE_TYPE a) noexcept {
+    return a;
+  }
+
+  static float reduce_maxf(FLOAT_TYPE a) noexcept {
+    return a;
+  }
+
+  static DOUBLE_TYPE rsqrt(DOUBLE_TYPE a) noexcept {
+    return 1.0 / std::sqrt(a);
+  }
+
+  static FLOAT_TYPE rsqrtf(FLOAT_TYPE a) noexcept {
+    return 1.0f / std::sqrt(a);
+  }
+
+  static DOUBLE_TYPE select_gt(DOUBLE_TYPE a, DOUBLE_TYPE b, DOUBLE_TYPE if_true, DOUBLE_TYPE if_false) noexcept {
+    return a > b ? if_true : if_false;
+  }
+
+  static FLOAT_TYPE select_gtf(FLOAT_TYPE a, FLOAT_TYPE b, FLOAT_TYPE if_true, FLOAT_TYPE if_false) noexcept {
+    return a > b ? if_true : if_false;
+  }
+
+  static void sincos(DOUBLE_TYPE a, DOUBLE_TYPE *s, DOUBLE_TYPE *c) noexcept {
+    *s = std::sin(a);
+    *c = std::cos(a);
+  }
+
+  static void sincosf(FLOAT_TYPE a, FLOAT_TYPE *s, FLOAT_TYPE *c) noexcept {
+    *s = std::sin(a);
+    *c = std::cos(a);
+  }
+
+  static DOUBLE_TYPE sqrt(DOUBLE_TYPE a) noexcept {
+    return std::sqrt(a);
+  }
+
+  static FLOAT_TYPE sqrtf(FLOAT_TYPE a) noexcept {
+    return std::sqrt(a);
+  }
+
+  static void store(double *a, DOUBLE_TYPE v) noexcept {
+    *a = v;
+  }
+
+  static void store_strided(double *a, size_t, DOUBLE_TYPE v) noexcept {
+    *a = v;
+  }
+
+  static void store_stridedf(float *a, size_t, FLOAT_TYPE v) noexcept {
+    *a = v;
+  }
+
+  static void storef(float *a, FLOAT_TYPE v) noexcept {
+    *a = v;
+  }
+
+  static DOUBLE_TYPE sub(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
+    return a - b;
+  }
+
+  static FLOAT_TYPE subf(FLOAT_TYPE a, FLOAT_TYPE b) noexcept {
+    return a - b;
+  }
+
   static DOUBLE_TYPE tanh(DOUBLE_TYPE a) noexcept {
     return Sleef_tanh_u10(a);
   }
@@ -225,4 +426,215 @@ struct Vector<Scalar> {
   }
 };
 
+/**
+ * Vector operations selected by element type, so that kernels that are
+ * identical for float and double can be written once.
+ */
+template <class T, class U>
+struct TypedVector;
+
+template <class T>
+struct TypedVector<T, double> {
+  typedef typename Vector<T>::DOUBLE_TYPE TYPE;
+  static size_t const N = Vector<T>::N_DOUBLE;
+
+  static TYPE add(TYPE a, TYPE b) noexcept {
+    return Vector<T>::add(a, b);
+  }
+
+  static TYPE broadcast(double a) noexcept {
+    return Vector<T>::broadcast(a);
+  }
+
+  static TYPE div(TYPE a, TYPE b) noexcept {
+    return Vector<T>::div(a, b);
+  }
+
+  static TYPE exp(TYPE a) noexcept {
+    return Vector<T>::exp(a);
+  }
+
+  static TYPE fma(TYPE a, TYPE b, TYPE c) noexcept {
+    return Vector<T>::fma(a, b, c);
+  }
+
+  static TYPE load(const double *a) noexcept {
+    return Vector<T>::load(a);
+  }
+
+  static TYPE load_strided(const double *a, size_t stride) noexcept {
+    return Vector<T>::load_strided(a, stride);
+  }
+
+  static TYPE log(TYPE a) noexcept {
+    return Vector<T>::log(a);
+  }
+
+  static TYPE logistic_cdf(TYPE a) noexcept {
+    return Vector<T>::logistic_cdf(a);
+  }
+
+  static TYPE logistic_pdf(TYPE a) noexcept {
+    return Vector<T>::logistic_pdf(a);
+  }
+
+  static TYPE max(TYPE a, TYPE b) noexcept {
+    return Vector<T>::max(a, b);
+  }
+
+  static TYPE mul(TYPE a, TYPE b) noexcept {
+    return Vector<T>::mul(a, b);
+  }
+
+  static TYPE normal_cdf(TYPE a) noexcept {
+    return Vector<T>::normal_cdf(a);
+  }
+
+  static TYPE normal_pdf(TYPE a) noexcept {
+    return Vector<T>::normal_pdf(a);
+  }
+
+  static double reduce_add(TYPE a) noexcept {
+    return Vector<T>::reduce_add(a);
+  }
+
+  static double reduce_max(TYPE a) noexcept {
+    return Vector<T>::reduce_max(a);
+  }
+
+  static TYPE rsqrt(TYPE a) noexcept {
+    return Vector<T>::rsqrt(a);
+  }
+
+  static TYPE select_gt(TYPE a, TYPE b, TYPE if_true, TYPE if_false) noexcept {
+    return Vector<T>::select_gt(a, b, if_true, if_false);
+  }
+
+  static void sincos(TYPE a, TYPE *s, TYPE *c) noexcept {
+    Vector<T>::sincos(a, s, c);
+  }
+
+  static TYPE sqrt(TYPE a) noexcept {
+    return Vector<T>::sqrt(a);
+  }
+
+  static void store(double *a, TYPE v) noexcept {
+    Vector<T>::store(a, v);
+  }
+
+  static void store_strided(double *a, size_t stride, TYPE v) noexcept {
+    Vector<T>::store_strided(a, stride, v);
+  }
+
+  static TYPE sub(TYPE a, TYPE b) noexcept {
+    return Vector<T>::sub(a, b);
+  }
+
+  static TYPE tanh(TYPE a) noexcept {
+    return Vector<T>::tanh(a);
+  }
+};
+
+template <class T>
+struct TypedVector<T, float> {
+  typedef typename Vector<T>::FLOAT_TYPE TYPE;
+  static size_t const N = Vector<T>::N_FLOAT;
+
+  static TYPE add(TYPE a, TYPE b) noexcept {
+    return Vector<T>::addf(a, b);
+  }
+
+  static TYPE broadcast(float a) noexcept {
+    return Vector<T>::broadcastf(a);
+  }
+
+  static TYPE div(TYPE a, TYPE b) noexcept {
+    return Vector<T>::divf(a, b);
+  }
+
+  static TYPE exp(TYPE a) noexcept {
+    return Vector<T>::expf(a);
+  }
+
+  static TYPE fma(TYPE a, TYPE b, TYPE c) noexcept {
+    return Vector<T>::fmaf(a, b, c);
+  }
+
+  static TYPE load(const float *a) noexcept {
+    return Vector<T>::loadf(a);
+  }
+
+  static TYPE load_strided(const float *a, size_t stride) noexcept {
+    return Vector<T>::load_stridedf(a, stride);
+  }
+
+  static TYPE log(TYPE a) noexcept {
+    return Vector<T>::logf(a);
+  }
+
+  static TYPE logistic_cdf(TYPE a) noexcept {
+    return Vector<T>::logistic_cdff(a);
+  }
+
+  static TYPE logistic_pdf(TYPE a) noexcept {
+    return Vector<T>::logistic_pdff(a);
+  }
+
+  static TYPE max(TYPE a, TYPE b) noexcept {
+    return Vector<T>::maxf(a, b);
+  }
+
+  static TYPE mul(TYPE a, TYPE b) noexcept {
+    return Vector<T>::mulf(a, b);
+  }
+
+  static TYPE normal_cdf(TYPE a) noexcept {
+    return Vector<T>::normal_cdff(a);
+  }
+
+  static TYPE normal_pdf(TYPE a) noexcept {
+    return Vector<T>::normal_pdff(a);
+  }
+
+  static float reduce_add(TYPE a) noexcept {
+    return Vector<T>::reduce_addf(a);
+  }
+
+  static float reduce_max(TYPE a) noexcept {
+    return Vector<T>::reduce_maxf(a);
+  }
+
+  static TYPE rsqrt(TYPE a) noexcept {
+    return Vector<T>::rsqrtf(a);
+  }
+
+  static TYPE select_gt(TYPE a, TYPE b, TYPE if_true, TYPE if_false) noexcept {
+    return Vector<T>::select_gtf(a, b, if_true, if_false);
+  }
+
+  static void sincos(TYPE a, TYPE *s, TYPE *c) noexcept {
+    Vector<T>::sincosf(a, s, c);
+  }
+
+  static TYPE sqrt(TYPE a) noexcept {
+    return Vector<T>::sqrtf(a);
+  }
+
+  static void store(float *a, TYPE v) noexcept {
+    Vector<T>::storef(a, v);
+  }
+
+  static void store_strided(float *a, size_t stride, TYPE v) noexcept {
+    Vector<T>::store_stridedf(a, stride, v);
+  }
+
+  static TYPE sub(TYPE a, TYPE b) noexcept {
+    return Vector<T>::subf(a, b);
+  }
+
+  static TYPE tanh(TYPE a) noexcept {
+    return Vector<T>::tanhf(a);
+  }
+};
+
 #endif // VECTOR_HH
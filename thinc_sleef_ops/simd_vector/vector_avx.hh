@@ -36,6 +36,14 @@ struct Vector<AVX> {
     return _mm256_add_ps(a, b_simd);
   }
 
+  static DOUBLE_TYPE broadcast(double a) noexcept {
+    return _mm256_set1_pd(a);
+  }
+
+  static FLOAT_TYPE broadcastf(float a) noexcept {
+    return _mm256_set1_ps(a);
+  }
+
   static DOUBLE_TYPE div(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
     return _mm256_div_pd(a, b);
   }
@@ -60,6 +68,40 @@ struct Vector<AVX> {
     return Sleef_expf8_u10(a);
   }
 
+  static DOUBLE_TYPE fma(DOUBLE_TYPE a, DOUBLE_TYPE b, DOUBLE_TYPE c) noexcept {
+    // FMA is a separate extension that not all AVX CPUs support.
+    return _mm256_add_pd(_mm256_mul_pd(a, b), c);
+  }
+
+  static FLOAT_TYPE fmaf(FLOAT_TYPE a, FLOAT_TYPE b, FLOAT_TYPE c) noexcept {
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+  }
+
+  static DOUBLE_TYPE load(const double *a) noexcept {
+    return _mm256_loadu_pd(a);
+  }
+
+  static DOUBLE_TYPE load_strided(const double *a, size_t stride) noexcept {
+    return _mm256_set_pd(a[3 * stride], a[2 * stride], a[stride], a[0]);
+  }
+
+  static FLOAT_TYPE load_stridedf(const float *a, size_t stride) noexcept {
+    return _mm256_set_ps(a[7 * stride], a[6 * stride], a[5 * stride], a[4 * stride],
+                         a[3 * stride], a[2 * stride], a[stride], a[0]);
+  }
+
+  static FLOAT_TYPE loadf(const float *a) noexcept {
+    return _mm256_loadu_ps(a);
+  }
+
+  static DOUBLE_TYPE log(DOUBLE_TYPE a) noexcept {
+    return Sleef_logd4_u10(a);
+  }
+
+  static FLOAT_TYPE logf(FLOAT_TYPE a) noexcept {
+    return Sleef_logf8_u10(a);
+  }
+
   static DOUBLE_TYPE logistic_cdf(DOUBLE_TYPE a) {
     return generic_logistic_cdf<AVX>(a);
   }
@@ -76,6 +118,14 @@ struct Vector<AVX> {
     return generic_logistic_pdff<AVX>(a);
   }
 
+  static DOUBLE_TYPE max(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
+    return _mm256_max_pd(a, b);
+  }
+
+  static FLOAT_TYPE maxf(FLOAT_TYPE a, FLOAT_TYPE b) noexcept {
+    return _mm256_max_ps(a, b);
+  }
+
   static DOUBLE_TYPE mul(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
     return _mm256_mul_pd(a, b);
   }
@@ -94,6 +144,18 @@ struct Vector<AVX> {
     return _mm256_mul_ps(a, b_simd);
   }
 
+  static void murmurhash3(uint32_t *out, const uint64_t *keys, uint32_t seed) noexcept {
+    for (size_t i = 0; i != N_DOUBLE; ++i) {
+      Vector<Scalar>::murmurhash3(out + i * 4, keys + i, seed);
+    }
+  }
+
+  static void murmurhash64a(uint64_t *out, const uint64_t *keys, size_t n, uint64_t seed) noexcept {
+    for (size_t i = 0; i != N_DOUBLE; ++i) {
+      Vector<Scalar>::murmurhash64a(out + i, keys + i, n, seed);
+    }
+  }
+
   static DOUBLE_TYPE neg(DOUBLE_TYPE a) noexcept {
     DOUBLE_TYPE minus_zero = _mm256_set1_pd(-0.0);
     return _mm256_xor_pd(a, minus_zero);
@@ -120,6 +182,12 @@ struct Vector<AVX> {
     return generic_normal_pdff<AVX>(a);
   }
 
+  static void philox(uint32_t *out, uint64_t counter, uint64_t seed) noexcept {
+    for (size_t i = 0; i != N_DOUBLE; ++i) {
+      Vector<Scalar>::philox(out + i * 4, counter + i, seed);
+    }
+  }
+
   static DOUBLE_TYPE recip(DOUBLE_TYPE a) noexcept {
     DOUBLE_TYPE one = _mm256_set1_pd(1.0);
     return _mm256_div_pd(one, a);
@@ -130,6 +198,106 @@ struct Vector<AVX> {
     return _mm256_div_ps(one, a);
   }
 
+  static double reduce_add(DOUBLE_TYPE a) noexcept {
+    __m128d sums = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+    __m128d high = _mm_unpackhi_pd(sums, sums);
+    return _mm_cvtsd_f64(_mm_add_sd(sums, high));
+  }
+
+  static float reduce_addf(FLOAT_TYPE a) noexcept {
+    __m128 sums = _mm_add_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+    sums = _mm_add_ps(sums, _mm_movehl_ps(sums, sums));
+    __m128 high = _mm_shuffle_ps(sums, sums, 1);
+    return _mm_cvtss_f32(_mm_add_ss(sums, high));
+  }
+
+  static double reduce_max(DOUBLE_TYPE a) noexcept {
+    __m128d maxes = _mm_max_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+    __m128d high = _mm_unpackhi_pd(maxes, maxes);
+    return _mm_cvtsd_f64(_mm_max_sd(maxes, high));
+  }
+
+  static float reduce_maxf(FLOAT_TYPE a) noexcept {
+    __m128 maxes = _mm_max_ps(_mm256_castps256_ps128(a), _mm256_extractf128_ps(a, 1));
+    maxes = _mm_max_ps(maxes, _mm_movehl_ps(maxes, maxes));
+    __m128 high = _mm_shuffle_ps(maxes, maxes, 1);
+    return _mm_cvtss_f32(_mm_max_ss(maxes, high));
+  }
+
+  static DOUBLE_TYPE rsqrt(DOUBLE_TYPE a) noexcept {
+    return _mm256_div_pd(_mm256_set1_pd(1.0), _mm256_sqrt_pd(a));
+  }
+
+  static FLOAT_TYPE rsqrtf(FLOAT_TYPE a) noexcept {
+    // 12-bit estimate, refined with a Newton-Raphson step
+    // r * (1.5 - 0.5 * a * r * r). a must be positive.
+    FLOAT_TYPE r = _mm256_rsqrt_ps(a);
+    FLOAT_TYPE half_a = _mm256_mul_ps(_mm256_set1_ps(0.5f), a);
+    return _mm256_mul_ps(r, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(half_a, _mm256_mul_ps(r, r))));
+  }
+
+  static DOUBLE_TYPE select_gt(DOUBLE_TYPE a, DOUBLE_TYPE b, DOUBLE_TYPE if_true, DOUBLE_TYPE if_false) noexcept {
+    DOUBLE_TYPE mask = _mm256_cmp_pd(a, b, _CMP_GT_OQ);
+    return _mm256_blendv_pd(if_false, if_true, mask);
+  }
+
+  static FLOAT_TYPE select_gtf(FLOAT_TYPE a, FLOAT_TYPE b, FLOAT_TYPE if_true, FLOAT_TYPE if_false) noexcept {
+    FLOAT_TYPE mask = _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+    return _mm256_blendv_ps(if_false, if_true, mask);
+  }
+
+  static void sincos(DOUBLE_TYPE a, DOUBLE_TYPE *s, DOUBLE_TYPE *c) noexcept {
+    auto r = Sleef_sincosd4_u10(a);
+    *s = r.x;
+    *c = r.y;
+  }
+
+  static void sincosf(FLOAT_TYPE a, FLOAT_TYPE *s, FLOAT_TYPE *c) noexcept {
+    auto r = Sleef_sincosf8_u10(a);
+    *s = r.x;
+    *c = r.y;
+  }
+
+  static DOUBLE_TYPE sqrt(DOUBLE_TYPE a) noexcept {
+    return _mm256_sqrt_pd(a);
+  }
+
+  static FLOAT_TYPE sqrtf(FLOAT_TYPE a) noexcept {
+    return _mm256_sqrt_ps(a);
+  }
+
+  static void store(double *a, DOUBLE_TYPE v) noexcept {
+    _mm256_storeu_pd(a, v);
+  }
+
+  static void store_strided(double *a, size_t stride, DOUBLE_TYPE v) noexcept {
+    double t[N_DOUBLE];
+    _mm256_storeu_pd(t, v);
+    for (size_t i = 0; i != N_DOUBLE; ++i) {
+      a[i * stride] = t[i];
+    }
+  }
+
+  static void store_stridedf(float *a, size_t stride, FLOAT_TYPE v) noexcept {
+    float t[N_FLOAT];
+    _mm256_storeu_ps(t, v);
+    for (size_t i = 0; i != N_FLOAT; ++i) {
+      a[i * stride] = t[i];
+    }
+  }
+
+  static void storef(float *a, FLOAT_TYPE v) noexcept {
+    _mm256_storeu_ps(a, v);
+  }
+
+  static DOUBLE_TYPE sub(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
+    return _mm256_sub_pd(a, b);
+  }
+
+  static FLOAT_TYPE subf(FLOAT_TYPE a, FLOAT_TYPE b) noexcept {
+    return _mm256_sub_ps(a, b);
+  }
+
   static DOUBLE_TYPE tanh(DOUBLE_TYPE a) {
     return Sleef_tanhd4_u10(a);
   }
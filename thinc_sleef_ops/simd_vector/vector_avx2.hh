@@ -0,0 +1,103 @@
+#ifndef VECTOR_AVX2_HH
+#define VECTOR_AVX2_HH
+
+#include <cstddef>
+#include <cstdint>
+
+#include "vector.hh"
+#include "vector_avx.hh"
+
+// AVX2 adds 256-bit integer instructions to AVX. The floating point
+// functions are the same as with AVX, so only the functions that work
+// on integer lanes are specialized.
+template <>
+struct Vector<AVX2> : Vector<AVX> {
+  // 64-bit multiplication, which AVX2 lacks, from 32-bit multiplications.
+  static __m256i mul_epi64(__m256i a, __m256i b) noexcept {
+    __m256i cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+                                     _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(_mm256_mul_epu32(a, b), _mm256_slli_epi64(cross, 32));
+  }
+
+  static void murmurhash3(uint32_t *out, const uint64_t *keys, uint32_t seed) noexcept {
+    __m256i h1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys));
+    h1 = mul_epi64(h1, _mm256_set1_epi64x(0x87c37b91114253d5ull));
+    h1 = _mm256_or_si256(_mm256_slli_epi64(h1, 31), _mm256_srli_epi64(h1, 33));
+    h1 = mul_epi64(h1, _mm256_set1_epi64x(0x4cf5ad432745937full));
+    __m256i h2 = _mm256_set1_epi64x(uint64_t(seed) ^ 8);
+    h1 = _mm256_xor_si256(h1, h2);
+    h1 = _mm256_add_epi64(h1, h2);
+    h2 = _mm256_add_epi64(h2, h1);
+    h1 = murmurhash3_fmix(h1);
+    h2 = murmurhash3_fmix(h2);
+    h1 = _mm256_add_epi64(h1, h2);
+    h2 = _mm256_add_epi64(h2, h1);
+    store_pairs(out, h1, h2);
+  }
+
+  static __m256i murmurhash3_fmix(__m256i h) noexcept {
+    h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 33));
+    h = mul_epi64(h, _mm256_set1_epi64x(0xff51afd7ed558ccdull));
+    h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 33));
+    h = mul_epi64(h, _mm256_set1_epi64x(0xc4ceb9fe1a85ec53ull));
+    return _mm256_xor_si256(h, _mm256_srli_epi64(h, 33));
+  }
+
+  static void murmurhash64a(uint64_t *out, const uint64_t *keys, size_t n, uint64_t seed) noexcept {
+    __m256i m = _mm256_set1_epi64x(0xc6a4a7935bd1e995ull);
+    __m256i h = _mm256_set1_epi64x(seed ^ (n * sizeof(uint64_t) * 0xc6a4a7935bd1e995ull));
+    for (size_t i = 0; i != n; ++i) {
+      __m256i k = mul_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(keys + i)), m);
+      k = _mm256_xor_si256(k, _mm256_srli_epi64(k, 47));
+      k = mul_epi64(k, m);
+      h = _mm256_xor_si256(h, k);
+      h = mul_epi64(h, m);
+    }
+
+    h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 47));
+    h = mul_epi64(h, m);
+    h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 47));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), h);
+  }
+
+  static void philox(uint32_t *out, uint64_t counter, uint64_t seed) noexcept {
+    // Lane i computes the block with counter counter + i, keeping each
+    // 32-bit word in the low half of a 64-bit lane. The high halves are
+    // left dirty during the rounds, because _mm256_mul_epu32 ignores them.
+    __m256i low = _mm256_set1_epi64x(0xffffffffull);
+    __m256i ctr = _mm256_add_epi64(_mm256_set1_epi64x(counter), _mm256_setr_epi64x(0, 1, 2, 3));
+    __m256i c0 = _mm256_and_si256(ctr, low);
+    __m256i c1 = _mm256_srli_epi64(ctr, 32);
+    __m256i c2 = _mm256_setzero_si256();
+    __m256i c3 = _mm256_setzero_si256();
+    uint32_t k0 = uint32_t(seed);
+    uint32_t k1 = uint32_t(seed >> 32);
+
+    for (int round = 0; round != 10; ++round) {
+      __m256i p0 = _mm256_mul_epu32(c0, _mm256_set1_epi64x(0xD2511F53));
+      __m256i p1 = _mm256_mul_epu32(c2, _mm256_set1_epi64x(0xCD9E8D57));
+      c0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c1), _mm256_set1_epi64x(k0));
+      c1 = p1;
+      c2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c3), _mm256_set1_epi64x(k1));
+      c3 = p0;
+      k0 += 0x9E3779B9;
+      k1 += 0xBB67AE85;
+    }
+
+    // (c0 c1, c2 c3) pairs are the four words per block.
+    store_pairs(out, _mm256_or_si256(_mm256_and_si256(c0, low), _mm256_slli_epi64(c1, 32)),
+                _mm256_or_si256(_mm256_and_si256(c2, low), _mm256_slli_epi64(c3, 32)));
+  }
+
+  // Stores the (a[i], b[i]) pairs of 64-bit lanes consecutively.
+  static void store_pairs(uint32_t *out, __m256i a, __m256i b) noexcept {
+    // The unpacks work within 128-bit halves, so lo holds pairs 0 and 2
+    // and hi holds pairs 1 and 3.
+    __m256i lo = _mm256_unpacklo_epi64(a, b);
+    __m256i hi = _mm256_unpackhi_epi64(a, b);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + 8), _mm256_permute2x128_si256(lo, hi, 0x31));
+  }
+};
+
+#endif // VECTOR_AVX2_HH
@@ -5,6 +5,7 @@
 
 #include <functional>
 #include <cstddef>
+#include <cstdint>
 
 #include "vector.hh"
 
@@ -48,6 +49,14 @@ struct Vector<AVX512> {
     return _mm512_add_ps(a, b_simd);
   }
 
+  static DOUBLE_TYPE broadcast(double a) noexcept {
+    return _mm512_set1_pd(a);
+  }
+
+  static FLOAT_TYPE broadcastf(float a) noexcept {
+    return _mm512_set1_ps(a);
+  }
+
   static DOUBLE_TYPE div(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
     return _mm512_div_pd(a, b);
   }
@@ -72,6 +81,42 @@ struct Vector<AVX512> {
     return Sleef_expf16_u10(a);
   }
 
+  static DOUBLE_TYPE fma(DOUBLE_TYPE a, DOUBLE_TYPE b, DOUBLE_TYPE c) noexcept {
+    return _mm512_fmadd_pd(a, b, c);
+  }
+
+  static FLOAT_TYPE fmaf(FLOAT_TYPE a, FLOAT_TYPE b, FLOAT_TYPE c) noexcept {
+    return _mm512_fmadd_ps(a, b, c);
+  }
+
+  static DOUBLE_TYPE load(const double *a) noexcept {
+    return _mm512_loadu_pd(a);
+  }
+
+  static DOUBLE_TYPE load_strided(const double *a, size_t stride) noexcept {
+    __m256i offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    offsets = _mm256_mullo_epi32(offsets, _mm256_set1_epi32(stride));
+    return _mm512_i32gather_pd(offsets, a, sizeof(double));
+  }
+
+  static FLOAT_TYPE load_stridedf(const float *a, size_t stride) noexcept {
+    __m512i offsets = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    offsets = _mm512_mullo_epi32(offsets, _mm512_set1_epi32(stride));
+    return _mm512_i32gather_ps(offsets, a, sizeof(float));
+  }
+
+  static FLOAT_TYPE loadf(const float *a) noexcept {
+    return _mm512_loadu_ps(a);
+  }
+
+  static DOUBLE_TYPE log(DOUBLE_TYPE a) noexcept {
+    return Sleef_logd8_u10(a);
+  }
+
+  static FLOAT_TYPE logf(FLOAT_TYPE a) noexcept {
+    return Sleef_logf16_u10(a);
+  }
+
   static DOUBLE_TYPE logistic_cdf(DOUBLE_TYPE a) {
     return generic_logistic_cdf<AVX512>(a);
   }
@@ -88,10 +133,25 @@ struct Vector<AVX512> {
     return generic_logistic_pdff<AVX512>(a);
   }
 
+  static DOUBLE_TYPE max(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
+    return _mm512_max_pd(a, b);
+  }
+
+  static FLOAT_TYPE maxf(FLOAT_TYPE a, FLOAT_TYPE b) noexcept {
+    return _mm512_max_ps(a, b);
+  }
+
   static DOUBLE_TYPE mul(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
     return _mm512_mul_pd(a, b);
   }
 
+  // Low 64 bits of a 64-bit product, since AVX-512F lacks vpmullq.
+  static __m512i mul_epi64(__m512i a, __m512i b) noexcept {
+    __m512i cross = _mm512_add_epi64(_mm512_mul_epu32(_mm512_srli_epi64(a, 32), b),
+                                     _mm512_mul_epu32(a, _mm512_srli_epi64(b, 32)));
+    return _mm512_add_epi64(_mm512_mul_epu32(a, b), _mm512_slli_epi64(cross, 32));
+  }
+
   static DOUBLE_TYPE mul_scalar(DOUBLE_TYPE a, double b) noexcept {
     DOUBLE_TYPE b_simd = _mm512_set1_pd(b);
     return _mm512_mul_pd(a, b_simd);
@@ -106,6 +166,51 @@ struct Vector<AVX512> {
     return _mm512_mul_ps(a, b_simd);
   }
 
+  static void murmurhash3(uint32_t *out, const uint64_t *keys, uint32_t seed) noexcept {
+    __m512i h1 = mul_epi64(_mm512_loadu_si512(keys), _mm512_set1_epi64(0x87c37b91114253d5ull));
+    h1 = _mm512_rol_epi64(h1, 31);
+    h1 = mul_epi64(h1, _mm512_set1_epi64(0x4cf5ad432745937full));
+    __m512i h2 = _mm512_set1_epi64(uint64_t(seed) ^ 8);
+    h1 = _mm512_xor_si512(h1, h2);
+    h1 = _mm512_add_epi64(h1, h2);
+    h2 = _mm512_add_epi64(h2, h1);
+    h1 = murmurhash3_fmix(h1);
+    h2 = murmurhash3_fmix(h2);
+    h1 = _mm512_add_epi64(h1, h2);
+    h2 = _mm512_add_epi64(h2, h1);
+
+    // Interleave to (h1, h2) pairs, which are the four 32-bit words per key.
+    __m512i lo = _mm512_setr_epi64(0, 8, 1, 9, 2, 10, 3, 11);
+    __m512i hi = _mm512_setr_epi64(4, 12, 5, 13, 6, 14, 7, 15);
+    _mm512_storeu_si512(out, _mm512_permutex2var_epi64(h1, lo, h2));
+    _mm512_storeu_si512(out + 16, _mm512_permutex2var_epi64(h1, hi, h2));
+  }
+
+  static __m512i murmurhash3_fmix(__m512i h) noexcept {
+    h = _mm512_xor_si512(h, _mm512_srli_epi64(h, 33));
+    h = mul_epi64(h, _mm512_set1_epi64(0xff51afd7ed558ccdull));
+    h = _mm512_xor_si512(h, _mm512_srli_epi64(h, 33));
+    h = mul_epi64(h, _mm512_set1_epi64(0xc4ceb9fe1a85ec53ull));
+    return _mm512_xor_si512(h, _mm512_srli_epi64(h, 33));
+  }
+
+  static void murmurhash64a(uint64_t *out, const uint64_t *keys, size_t n, uint64_t seed) noexcept {
+    __m512i m = _mm512_set1_epi64(0xc6a4a7935bd1e995ull);
+    __m512i h = _mm512_set1_epi64(seed ^ (n * sizeof(uint64_t) * 0xc6a4a7935bd1e995ull));
+    for (size_t i = 0; i != n; ++i) {
+      __m512i k = mul_epi64(_mm512_loadu_si512(keys + i), m);
+      k = _mm512_xor_si512(k, _mm512_srli_epi64(k, 47));
+      k = mul_epi64(k, m);
+      h = _mm512_xor_si512(h, k);
+      h = mul_epi64(h, m);
+    }
+
+    h = _mm512_xor_si512(h, _mm512_srli_epi64(h, 47));
+    h = mul_epi64(h, m);
+    h = _mm512_xor_si512(h, _mm512_srli_epi64(h, 47));
+    _mm512_storeu_si512(out, h);
+  }
+
   static DOUBLE_TYPE neg(DOUBLE_TYPE a) noexcept {
     DOUBLE_TYPE minus_zero = _mm512_set1_pd(-0.0);
     return _mm512_xor_pd(a, minus_zero);
@@ -132,6 +237,38 @@ struct Vector<AVX512> {
     return _mm512_xor_ps(a, minus_zero);
   }
 
+  static void philox(uint32_t *out, uint64_t counter, uint64_t seed) noexcept {
+    // Lane i computes the block with counter counter + i, keeping each
+    // 32-bit word in the low half of a 64-bit lane.
+    __m512i low = _mm512_set1_epi64(0xffffffffull);
+    __m512i ctr = _mm512_add_epi64(_mm512_set1_epi64(counter), _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7));
+    __m512i c0 = _mm512_and_si512(ctr, low);
+    __m512i c1 = _mm512_srli_epi64(ctr, 32);
+    __m512i c2 = _mm512_setzero_si512();
+    __m512i c3 = _mm512_setzero_si512();
+    uint32_t k0 = uint32_t(seed);
+    uint32_t k1 = uint32_t(seed >> 32);
+
+    for (int round = 0; round != 10; ++round) {
+      __m512i p0 = _mm512_mul_epu32(c0, _mm512_set1_epi64(0xD2511F53));
+      __m512i p1 = _mm512_mul_epu32(c2, _mm512_set1_epi64(0xCD9E8D57));
+      c0 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p1, 32), c1), _mm512_set1_epi64(k0));
+      c1 = _mm512_and_si512(p1, low);
+      c2 = _mm512_xor_si512(_mm512_xor_si512(_mm512_srli_epi64(p0, 32), c3), _mm512_set1_epi64(k1));
+      c3 = _mm512_and_si512(p0, low);
+      k0 += 0x9E3779B9;
+      k1 += 0xBB67AE85;
+    }
+
+    // Interleave to (c0 c1, c2 c3) pairs, which are the four words per block.
+    __m512i w01 = _mm512_or_si512(c0, _mm512_slli_epi64(c1, 32));
+    __m512i w23 = _mm512_or_si512(c2, _mm512_slli_epi64(c3, 32));
+    __m512i lo = _mm512_setr_epi64(0, 8, 1, 9, 2, 10, 3, 11);
+    __m512i hi = _mm512_setr_epi64(4, 12, 5, 13, 6, 14, 7, 15);
+    _mm512_storeu_si512(out, _mm512_permutex2var_epi64(w01, lo, w23));
+    _mm512_storeu_si512(out + 16, _mm512_permutex2var_epi64(w01, hi, w23));
+  }
+
   static DOUBLE_TYPE recip(DOUBLE_TYPE a) noexcept {
     // Use division rather than reciprocal instruction, for
     // higher precision. Not sure if we care?
@@ -146,6 +283,92 @@ struct Vector<AVX512> {
     return _mm512_div_ps(one, a);
   }
 
+  static double reduce_add(DOUBLE_TYPE a) noexcept {
+    return _mm512_reduce_add_pd(a);
+  }
+
+  static float reduce_addf(FLOAT_TYPE a) noexcept {
+    return _mm512_reduce_add_ps(a);
+  }
+
+  static double reduce_max(DOUBLE_TYPE a) noexcept {
+    return _mm512_reduce_max_pd(a);
+  }
+
+  static float reduce_maxf(FLOAT_TYPE a) noexcept {
+    return _mm512_reduce_max_ps(a);
+  }
+
+  static DOUBLE_TYPE rsqrt(DOUBLE_TYPE a) noexcept {
+    return _mm512_div_pd(_mm512_set1_pd(1.0), _mm512_sqrt_pd(a));
+  }
+
+  static FLOAT_TYPE rsqrtf(FLOAT_TYPE a) noexcept {
+    // 14-bit estimate, refined with a Newton-Raphson step
+    // r * (1.5 - 0.5 * a * r * r). a must be positive.
+    FLOAT_TYPE r = _mm512_rsqrt14_ps(a);
+    FLOAT_TYPE half_a = _mm512_mul_ps(_mm512_set1_ps(0.5f), a);
+    return _mm512_mul_ps(r, _mm512_fnmadd_ps(half_a, _mm512_mul_ps(r, r), _mm512_set1_ps(1.5f)));
+  }
+
+  static DOUBLE_TYPE select_gt(DOUBLE_TYPE a, DOUBLE_TYPE b, DOUBLE_TYPE if_true, DOUBLE_TYPE if_false) noexcept {
+    __mmask8 mask = _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ);
+    return _mm512_mask_blend_pd(mask, if_false, if_true);
+  }
+
+  static FLOAT_TYPE select_gtf(FLOAT_TYPE a, FLOAT_TYPE b, FLOAT_TYPE if_true, FLOAT_TYPE if_false) noexcept {
+    __mmask16 mask = _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ);
+    return _mm512_mask_blend_ps(mask, if_false, if_true);
+  }
+
+  static void sincos(DOUBLE_TYPE a, DOUBLE_TYPE *s, DOUBLE_TYPE *c) noexcept {
+    auto r = Sleef_sincosd8_u10(a);
+    *s = r.x;
+    *c = r.y;
+  }
+
+  static void sincosf(FLOAT_TYPE a, FLOAT_TYPE *s, FLOAT_TYPE *c) noexcept {
+    auto r = Sleef_sincosf16_u10(a);
+    *s = r.x;
+    *c = r.y;
+  }
+
+  static DOUBLE_TYPE sqrt(DOUBLE_TYPE a) noexcept {
+    return _mm512_sqrt_pd(a);
+  }
+
+  static FLOAT_TYPE sqrtf(FLOAT_TYPE a) noexcept {
+    return _mm512_sqrt_ps(a);
+  }
+
+  static void store(double *a, DOUBLE_TYPE v) noexcept {
+    _mm512_storeu_pd(a, v);
+  }
+
+  static void store_strided(double *a, size_t stride, DOUBLE_TYPE v) noexcept {
+    __m256i offsets = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    offsets = _mm256_mullo_epi32(offsets, _mm256_set1_epi32(stride));
+    _mm512_i32scatter_pd(a, offsets, v, sizeof(double));
+  }
+
+  static void store_stridedf(float *a, size_t stride, FLOAT_TYPE v) noexcept {
+    __m512i offsets = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    offsets = _mm512_mullo_epi32(offsets, _mm512_set1_epi32(stride));
+    _mm512_i32scatter_ps(a, offsets, v, sizeof(float));
+  }
+
+  static void storef(float *a, FLOAT_TYPE v) noexcept {
+    _mm512_storeu_ps(a, v);
+  }
+
+  static DOUBLE_TYPE sub(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
+    return _mm512_sub_pd(a, b);
+  }
+
+  static FLOAT_TYPE subf(FLOAT_TYPE a, FLOAT_TYPE b) noexcept {
+    return _mm512_sub_ps(a, b);
+  }
+
   static DOUBLE_TYPE tanh(DOUBLE_TYPE a) {
     return Sleef_tanhd8_u10(a);
   }
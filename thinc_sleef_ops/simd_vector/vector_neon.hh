@@ -36,6 +36,14 @@ struct Vector<NEON> {
     return vaddq_f32(a, b);
   }
 
+  static DOUBLE_TYPE broadcast(double a) noexcept {
+    return vdupq_n_f64(a);
+  }
+
+  static FLOAT_TYPE broadcastf(float a) noexcept {
+    return vdupq_n_f32(a);
+  }
+
   static DOUBLE_TYPE div(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
     return vdivq_f64(a, b);
   }
@@ -60,6 +68,40 @@ struct Vector<NEON> {
     return Sleef_expf4_u10(a);
   }
 
+  static DOUBLE_TYPE fma(DOUBLE_TYPE a, DOUBLE_TYPE b, DOUBLE_TYPE c) noexcept {
+    return vfmaq_f64(c, a, b);
+  }
+
+  static FLOAT_TYPE fmaf(FLOAT_TYPE a, FLOAT_TYPE b, FLOAT_TYPE c) noexcept {
+    return vfmaq_f32(c, a, b);
+  }
+
+  static DOUBLE_TYPE load(const double *a) noexcept {
+    return vld1q_f64(a);
+  }
+
+  static DOUBLE_TYPE load_strided(const double *a, size_t stride) noexcept {
+    DOUBLE_TYPE r = vdupq_n_f64(a[0]);
+    return vsetq_lane_f64(a[stride], r, 1);
+  }
+
+  static FLOAT_TYPE load_stridedf(const float *a, size_t stride) noexcept {
+    float lanes[4] = {a[0], a[stride], a[2 * stride], a[3 * stride]};
+    return vld1q_f32(lanes);
+  }
+
+  static FLOAT_TYPE loadf(const float *a) noexcept {
+    return vld1q_f32(a);
+  }
+
+  static DOUBLE_TYPE log(DOUBLE_TYPE a) noexcept {
+    return Sleef_logd2_u10(a);
+  }
+
+  static FLOAT_TYPE logf(FLOAT_TYPE a) noexcept {
+    return Sleef_logf4_u10(a);
+  }
+
   static DOUBLE_TYPE logistic_cdf(DOUBLE_TYPE a) {
     return generic_logistic_cdf<NEON>(a);
   }
@@ -76,6 +118,14 @@ struct Vector<NEON> {
     return generic_logistic_pdff<NEON>(a);
   }
 
+  static DOUBLE_TYPE max(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
+    return vmaxq_f64(a, b);
+  }
+
+  static FLOAT_TYPE maxf(FLOAT_TYPE a, FLOAT_TYPE b) noexcept {
+    return vmaxq_f32(a, b);
+  }
+
   static DOUBLE_TYPE mul(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
     return vmulq_f64(a, b);
   }
@@ -94,6 +144,18 @@ struct Vector<NEON> {
     return vmulq_f32(a, v_simd);
   }
 
+  static void murmurhash3(uint32_t *out, const uint64_t *keys, uint32_t seed) noexcept {
+    for (size_t i = 0; i != N_DOUBLE; ++i) {
+      Vector<Scalar>::murmurhash3(out + i * 4, keys + i, seed);
+    }
+  }
+
+  static void murmurhash64a(uint64_t *out, const uint64_t *keys, size_t n, uint64_t seed) noexcept {
+    for (size_t i = 0; i != N_DOUBLE; ++i) {
+      Vector<Scalar>::murmurhash64a(out + i, keys + i, n, seed);
+    }
+  }
+
   static DOUBLE_TYPE neg(DOUBLE_TYPE a) noexcept {
     return vnegq_f64(a);
   }
@@ -118,6 +180,28 @@ struct Vector<NEON> {
     return generic_normal_pdff<NEON>(a);
   }
 
+  static void philox(uint32_t *out, uint64_t counter, uint64_t seed) noexcept {
+    // Lane i computes the block with counter counter + i.
+    uint64x2_t ctr = vaddq_u64(vdupq_n_u64(counter), vcombine_u64(vcreate_u64(0), vcreate_u64(1)));
+    uint32x2x4_t c = {{vmovn_u64(ctr), vshrn_n_u64(ctr, 32), vdup_n_u32(0), vdup_n_u32(0)}};
+    uint32_t k0 = uint32_t(seed);
+    uint32_t k1 = uint32_t(seed >> 32);
+
+    for (int round = 0; round != 10; ++round) {
+      uint64x2_t p0 = vmull_n_u32(c.val[0], 0xD2511F53);
+      uint64x2_t p1 = vmull_n_u32(c.val[2], 0xCD9E8D57);
+      c.val[0] = veor_u32(veor_u32(vshrn_n_u64(p1, 32), c.val[1]), vdup_n_u32(k0));
+      c.val[1] = vmovn_u64(p1);
+      c.val[2] = veor_u32(veor_u32(vshrn_n_u64(p0, 32), c.val[3]), vdup_n_u32(k1));
+      c.val[3] = vmovn_u64(p0);
+      k0 += 0x9E3779B9;
+      k1 += 0xBB67AE85;
+    }
+
+    // Interleaving stores the four words of each block consecutively.
+    vst4_u32(out, c);
+  }
+
   static DOUBLE_TYPE recip(DOUBLE_TYPE a) noexcept {
     DOUBLE_TYPE one = vdupq_n_f64(1);
     return vdivq_f64(one, a);
@@ -128,6 +212,90 @@ struct Vector<NEON> {
     return vdivq_f32(one, a);
   }
 
+  static double reduce_add(DOUBLE_TYPE a) noexcept {
+    return vaddvq_f64(a);
+  }
+
+  static float reduce_addf(FLOAT_TYPE a) noexcept {
+    return vaddvq_f32(a);
+  }
+
+  static double reduce_max(DOUBLE_TYPE a) noexcept {
+    return vmaxvq_f64(a);
+  }
+
+  static float reduce_maxf(FLOAT_TYPE a) noexcept {
+    return vmaxvq_f32(a);
+  }
+
+  static DOUBLE_TYPE rsqrt(DOUBLE_TYPE a) noexcept {
+    return vdivq_f64(vdupq_n_f64(1), vsqrtq_f64(a));
+  }
+
+  static FLOAT_TYPE rsqrtf(FLOAT_TYPE a) noexcept {
+    // 8-bit estimate, refined with two Newton-Raphson steps. vrsqrtsq
+    // computes (3 - a * b) / 2. a must be positive.
+    FLOAT_TYPE r = vrsqrteq_f32(a);
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+    return vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+  }
+
+  static DOUBLE_TYPE select_gt(DOUBLE_TYPE a, DOUBLE_TYPE b, DOUBLE_TYPE if_true, DOUBLE_TYPE if_false) noexcept {
+    return vbslq_f64(vcgtq_f64(a, b), if_true, if_false);
+  }
+
+  static FLOAT_TYPE select_gtf(FLOAT_TYPE a, FLOAT_TYPE b, FLOAT_TYPE if_true, FLOAT_TYPE if_false) noexcept {
+    return vbslq_f32(vcgtq_f32(a, b), if_true, if_false);
+  }
+
+  static void sincos(DOUBLE_TYPE a, DOUBLE_TYPE *s, DOUBLE_TYPE *c) noexcept {
+    auto r = Sleef_sincosd2_u10(a);
+    *s = r.x;
+    *c = r.y;
+  }
+
+  static void sincosf(FLOAT_TYPE a, FLOAT_TYPE *s, FLOAT_TYPE *c) noexcept {
+    auto r = Sleef_sincosf4_u10(a);
+    *s = r.x;
+    *c = r.y;
+  }
+
+  static DOUBLE_TYPE sqrt(DOUBLE_TYPE a) noexcept {
+    return vsqrtq_f64(a);
+  }
+
+  static FLOAT_TYPE sqrtf(FLOAT_TYPE a) noexcept {
+    return vsqrtq_f32(a);
+  }
+
+  static void store(double *a, DOUBLE_TYPE v) noexcept {
+    vst1q_f64(a, v);
+  }
+
+  static void store_strided(double *a, size_t stride, DOUBLE_TYPE v) noexcept {
+    vst1q_lane_f64(a, v, 0);
+    vst1q_lane_f64(a + stride, v, 1);
+  }
+
+  static void store_stridedf(float *a, size_t stride, FLOAT_TYPE v) noexcept {
+    vst1q_lane_f32(a, v, 0);
+    vst1q_lane_f32(a + stride, v, 1);
+    vst1q_lane_f32(a + 2 * stride, v, 2);
+    vst1q_lane_f32(a + 3 * stride, v, 3);
+  }
+
+  static void storef(float *a, FLOAT_TYPE v) noexcept {
+    vst1q_f32(a, v);
+  }
+
+  static DOUBLE_TYPE sub(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
+    return vsubq_f64(a, b);
+  }
+
+  static FLOAT_TYPE subf(FLOAT_TYPE a, FLOAT_TYPE b) noexcept {
+    return vsubq_f32(a, b);
+  }
+
   static DOUBLE_TYPE tanh(DOUBLE_TYPE a) noexcept {
     return Sleef_tanhd2_u10(a);
   }
@@ -36,6 +36,14 @@ struct Vector<SSE> {
     return _mm_add_ps(a, b_simd);
   }
 
+  static DOUBLE_TYPE broadcast(double a) noexcept {
+    return _mm_set1_pd(a);
+  }
+
+  static FLOAT_TYPE broadcastf(float a) noexcept {
+    return _mm_set1_ps(a);
+  }
+
   static DOUBLE_TYPE div(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
     return _mm_div_pd(a, b);
   }
@@ -60,6 +68,39 @@ struct Vector<SSE> {
     return Sleef_expf4_u10(a);
   }
 
+  static DOUBLE_TYPE fma(DOUBLE_TYPE a, DOUBLE_TYPE b, DOUBLE_TYPE c) noexcept {
+    // FMA is not part of SSE2.
+    return _mm_add_pd(_mm_mul_pd(a, b), c);
+  }
+
+  static FLOAT_TYPE fmaf(FLOAT_TYPE a, FLOAT_TYPE b, FLOAT_TYPE c) noexcept {
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+  }
+
+  static DOUBLE_TYPE load(const double *a) noexcept {
+    return _mm_loadu_pd(a);
+  }
+
+  static DOUBLE_TYPE load_strided(const double *a, size_t stride) noexcept {
+    return _mm_set_pd(a[stride], a[0]);
+  }
+
+  static FLOAT_TYPE load_stridedf(const float *a, size_t stride) noexcept {
+    return _mm_set_ps(a[3 * stride], a[2 * stride], a[stride], a[0]);
+  }
+
+  static FLOAT_TYPE loadf(const float *a) noexcept {
+    return _mm_loadu_ps(a);
+  }
+
+  static DOUBLE_TYPE log(DOUBLE_TYPE a) noexcept {
+    return Sleef_logd2_u10(a);
+  }
+
+  static FLOAT_TYPE logf(FLOAT_TYPE a) noexcept {
+    return Sleef_logf4_u10(a);
+  }
+
   static DOUBLE_TYPE logistic_cdf(DOUBLE_TYPE a) {
     return generic_logistic_cdf<SSE>(a);
   }
@@ -76,6 +117,14 @@ struct Vector<SSE> {
     return generic_logistic_pdff<SSE>(a);
   }
 
+  static DOUBLE_TYPE max(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
+    return _mm_max_pd(a, b);
+  }
+
+  static FLOAT_TYPE maxf(FLOAT_TYPE a, FLOAT_TYPE b) noexcept {
+    return _mm_max_ps(a, b);
+  }
+
   static DOUBLE_TYPE mul(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
     return _mm_mul_pd(a, b);
   }
@@ -94,6 +143,18 @@ struct Vector<SSE> {
     return _mm_mul_ps(a, b_simd);
   }
 
+  static void murmurhash3(uint32_t *out, const uint64_t *keys, uint32_t seed) noexcept {
+    for (size_t i = 0; i != N_DOUBLE; ++i) {
+      Vector<Scalar>::murmurhash3(out + i * 4, keys + i, seed);
+    }
+  }
+
+  static void murmurhash64a(uint64_t *out, const uint64_t *keys, size_t n, uint64_t seed) noexcept {
+    for (size_t i = 0; i != N_DOUBLE; ++i) {
+      Vector<Scalar>::murmurhash64a(out + i, keys + i, n, seed);
+    }
+  }
+
   static DOUBLE_TYPE neg(DOUBLE_TYPE a) noexcept {
     DOUBLE_TYPE minus_zero = _mm_set1_pd(-0.0);
     return _mm_xor_pd(a, minus_zero);
@@ -120,6 +181,14 @@ struct Vector<SSE> {
     return generic_normal_pdff<SSE>(a);
   }
 
+  static void philox(uint32_t *out, uint64_t counter, uint64_t seed) noexcept {
+    // Two blocks per 128-bit vector do not make up for the extra shuffles
+    // around _mm_mul_epu32, so the scalar rounds are faster here.
+    for (size_t i = 0; i != N_DOUBLE; ++i) {
+      Vector<Scalar>::philox(out + i * 4, counter + i, seed);
+    }
+  }
+
   static DOUBLE_TYPE recip(DOUBLE_TYPE a) noexcept {
     DOUBLE_TYPE one = _mm_set1_pd(1.0);
     return _mm_div_pd(one, a);
@@ -130,6 +199,100 @@ struct Vector<SSE> {
     return _mm_div_ps(one, a);
   }
 
+  static double reduce_add(DOUBLE_TYPE a) noexcept {
+    DOUBLE_TYPE high = _mm_unpackhi_pd(a, a);
+    return _mm_cvtsd_f64(_mm_add_sd(a, high));
+  }
+
+  static float reduce_addf(FLOAT_TYPE a) noexcept {
+    FLOAT_TYPE sums = _mm_add_ps(a, _mm_movehl_ps(a, a));
+    FLOAT_TYPE high = _mm_shuffle_ps(sums, sums, 1);
+    return _mm_cvtss_f32(_mm_add_ss(sums, high));
+  }
+
+  static double reduce_max(DOUBLE_TYPE a) noexcept {
+    DOUBLE_TYPE high = _mm_unpackhi_pd(a, a);
+    return _mm_cvtsd_f64(_mm_max_sd(a, high));
+  }
+
+  static float reduce_maxf(FLOAT_TYPE a) noexcept {
+    FLOAT_TYPE maxes = _mm_max_ps(a, _mm_movehl_ps(a, a));
+    FLOAT_TYPE high = _mm_shuffle_ps(maxes, maxes, 1);
+    return _mm_cvtss_f32(_mm_max_ss(maxes, high));
+  }
+
+  static DOUBLE_TYPE rsqrt(DOUBLE_TYPE a) noexcept {
+    return _mm_div_pd(_mm_set1_pd(1.0), _mm_sqrt_pd(a));
+  }
+
+  static FLOAT_TYPE rsqrtf(FLOAT_TYPE a) noexcept {
+    // 12-bit estimate, refined with a Newton-Raphson step
+    // r * (1.5 - 0.5 * a * r * r). a must be positive.
+    FLOAT_TYPE r = _mm_rsqrt_ps(a);
+    FLOAT_TYPE half_a = _mm_mul_ps(_mm_set1_ps(0.5f), a);
+    return _mm_mul_ps(r, _mm_sub_ps(_mm_set1_ps(1.5f), _mm_mul_ps(half_a, _mm_mul_ps(r, r))));
+  }
+
+  static DOUBLE_TYPE select_gt(DOUBLE_TYPE a, DOUBLE_TYPE b, DOUBLE_TYPE if_true, DOUBLE_TYPE if_false) noexcept {
+    // No blendv in SSE2, select using the comparison bit mask.
+    DOUBLE_TYPE mask = _mm_cmpgt_pd(a, b);
+    return _mm_or_pd(_mm_and_pd(mask, if_true), _mm_andnot_pd(mask, if_false));
+  }
+
+  static FLOAT_TYPE select_gtf(FLOAT_TYPE a, FLOAT_TYPE b, FLOAT_TYPE if_true, FLOAT_TYPE if_false) noexcept {
+    FLOAT_TYPE mask = _mm_cmpgt_ps(a, b);
+    return _mm_or_ps(_mm_and_ps(mask, if_true), _mm_andnot_ps(mask, if_false));
+  }
+
+  static void sincos(DOUBLE_TYPE a, DOUBLE_TYPE *s, DOUBLE_TYPE *c) noexcept {
+    auto r = Sleef_sincosd2_u10(a);
+    *s = r.x;
+    *c = r.y;
+  }
+
+  static void sincosf(FLOAT_TYPE a, FLOAT_TYPE *s, FLOAT_TYPE *c) noexcept {
+    auto r = Sleef_sincosf4_u10(a);
+    *s = r.x;
+    *c = r.y;
+  }
+
+  static DOUBLE_TYPE sqrt(DOUBLE_TYPE a) noexcept {
+    return _mm_sqrt_pd(a);
+  }
+
+  static FLOAT_TYPE sqrtf(FLOAT_TYPE a) noexcept {
+    return _mm_sqrt_ps(a);
+  }
+
+  static void store(double *a, DOUBLE_TYPE v) noexcept {
+    _mm_storeu_pd(a, v);
+  }
+
+  static void store_strided(double *a, size_t stride, DOUBLE_TYPE v) noexcept {
+    _mm_storel_pd(a, v);
+    _mm_storeh_pd(a + stride, v);
+  }
+
+  static void store_stridedf(float *a, size_t stride, FLOAT_TYPE v) noexcept {
+    float t[N_FLOAT];
+    _mm_storeu_ps(t, v);
+    for (size_t i = 0; i != N_FLOAT; ++i) {
+      a[i * stride] = t[i];
+    }
+  }
+
+  static void storef(float *a, FLOAT_TYPE v) noexcept {
+    _mm_storeu_ps(a, v);
+  }
+
+  static DOUBLE_TYPE sub(DOUBLE_TYPE a, DOUBLE_TYPE b) noexcept {
+    return _mm_sub_pd(a, b);
+  }
+
+  static FLOAT_TYPE subf(FLOAT_TYPE a, FLOAT_TYPE b) noexcept {
+    return _mm_sub_ps(a, b);
+  }
+
   static DOUBLE_TYPE tanh(DOUBLE_TYPE a) noexcept {
     return Sleef_tanhd2_u10(a);
   }
@@ -1,4 +1,4 @@
-from libc.stdint cimport uint8_t
+from libc.stdint cimport uint8_t, uint32_t, uint64_t
 from libcpp.memory cimport unique_ptr
 from libcpp.string cimport string
 from libcpp.unordered_set cimport unordered_set
@@ -8,6 +8,9 @@ ctypedef double[::1] double1d_t
 ctypedef float* floats_t
 ctypedef double* doubles_t
 
+ctypedef float** floats_ptrs_t
+ctypedef double** doubles_ptrs_t
+
 ctypedef size_t dim_t
 
 cdef fused reals_ft:
@@ -16,46 +19,191 @@ cdef fused reals_ft:
     float1d_t
     double1d_t
 
+cdef fused reals_ptrs_ft:
+    floats_ptrs_t
+    doubles_ptrs_t
+
 cdef extern from "simd_array/array_base.hh":
+     # Note: keep in sync with array_base.hh
+     cpdef enum Activation:
+         ACTIVATION_GELU,
+         ACTIVATION_IDENTITY,
+         ACTIVATION_RELU,
+         ACTIVATION_SIGMOID,
+         ACTIVATION_SWISH,
+         ACTIVATION_TANH
+
+     ctypedef struct AdamParams:
+         double beta1
+         double beta2
+         double eps
+         double learn_rate
+         double mod_rate
+         double grad_scale
+         double L2
+         double weight_decay
+
      cdef cppclass ArrayBase:
+         void adam(double *weights, const double *gradient, double *mom1, double *mom2, size_t n, const AdamParams &params)
+         double adam_multi(double **weights, const double **gradients, double **mom1, double **mom2, const size_t *sizes, size_t n_tensors, const AdamParams &params, double grad_clip)
+         void adam_rows(double *weights, const double *gradient, double *mom1, double *mom2, int *last_step, const int *rows, size_t n_rows, size_t nO, int step, const AdamParams &params)
+         void adamf(float *weights, const float *gradient, float *mom1, float *mom2, size_t n, const AdamParams &params)
+         double adamf_multi(float **weights, const float **gradients, float **mom1, float **mom2, const size_t *sizes, size_t n_tensors, const AdamParams &params, double grad_clip)
+         void adamf_rows(float *weights, const float *gradient, float *mom1, float *mom2, int *last_step, const int *rows, size_t n_rows, size_t nO, int step, const AdamParams &params)
+         void affine(double *Y, const double *X, const double *packed, const double *b, size_t n, size_t nO, size_t nI, Activation activation)
+         void affine_pack(double *packed, const double *W, size_t nO, size_t nI)
+         size_t affine_packed_size(size_t nO, size_t nI)
+         void affinef(float *Y, const float *X, const float *packed, const float *b, size_t n, size_t nO, size_t nI, Activation activation)
+         void affinef_pack(float *packed, const float *W, size_t nO, size_t nI)
+         size_t affinef_packed_size(size_t nO, size_t nI)
+         void argmax(double *best, int *which, const double *X, size_t n, size_t nO)
+         void argmaxf(float *best, int *which, const float *X, size_t n, size_t nO)
+         void attention(double *out, const double *Q, const double *K, const double *V, const int *lengths, size_t n_batch, size_t n_q, size_t n_k, size_t d, size_t d_v, double scale)
+         void attentionf(float *out, const float *Q, const float *K, const float *V, const int *lengths, size_t n_batch, size_t n_q, size_t n_k, size_t d, size_t d_v, double scale)
+         void bias_act(double *Y, double *D, const double *b, size_t n, size_t nO, Activation activation)
+         void bias_act_backward(double *dX, double *db, const double *dY, const double *D, size_t n, size_t nO)
+         void bias_actf(float *Y, float *D, const float *b, size_t n, size_t nO, Activation activation)
+         void bias_actf_backward(float *dX, float *db, const float *dY, const float *D, size_t n, size_t nO)
+         double clip_gradient(double *gradient, size_t n, double threshold)
+         void clip_gradient_multi(double **gradients, const size_t *sizes, size_t n_tensors, double threshold, double *norms)
+         double clip_gradientf(float *gradient, size_t n, double threshold)
+         void clip_gradientf_multi(float **gradients, const size_t *sizes, size_t n_tensors, double threshold, double *norms)
+         void cosine_similarity(double *out, const double *A, const double *B, size_t n_a, size_t n_b, size_t d, double eps)
+         void cosine_similarityf(float *out, const float *A, const float *B, size_t n_a, size_t n_b, size_t d, double eps)
+         void dropout(double *X, size_t n, double drop, uint64_t seed, uint64_t offset)
+         void dropout_mask(double *mask, size_t n, double drop, uint64_t seed, uint64_t offset)
+         void dropoutf(float *X, size_t n, double drop, uint64_t seed, uint64_t offset)
+         void dropoutf_mask(float *mask, size_t n, double drop, uint64_t seed, uint64_t offset)
          void erf(double *a, size_t n)
          void erff(float *a, size_t n)
          void exp(double *a, size_t n)
          void expf(float *a, size_t n)
+         void flatten(double *out, const double **seqs, const int *lengths, size_t n_seqs, size_t nO, size_t pad)
+         void flattenf(float *out, const float **seqs, const int *lengths, size_t n_seqs, size_t nO, size_t pad)
+         void gather_add(double *out, const double *table, const int *indices, size_t n, size_t n_idx, size_t nO)
+         void gather_addf(float *out, const float *table, const int *indices, size_t n, size_t n_idx, size_t nO)
          void gelu(double *a, size_t n)
          void gelu_backward(double* a, size_t n)
          void geluf(float *a, size_t n)
          void geluf_backward(float* a, size_t n)
+         void hash(uint32_t *out, const uint64_t *keys, size_t n, uint32_t seed)
+         void hash_embed(double *out, int *keys, const double *table, const uint64_t *ids, size_t n, size_t nV, size_t nO, uint32_t seed)
+         void hash_embedf(float *out, int *keys, const float *table, const uint64_t *ids, size_t n, size_t nV, size_t nO, uint32_t seed)
+         void l2_normalize(double *X, size_t n, size_t nO, double eps)
+         void l2_normalizef(float *X, size_t n, size_t nO, double eps)
          void logistic_cdf(double *a, size_t n)
          void logistic_cdff(float *a, size_t n)
+         void lstm_gates(double *Y, double *C, double *G, const double *C_prev, size_t n)
+         void lstm_gates_backward(double *dG, double *dC_prev, const double *dY, const double *dC, const double *G, const double *C, const double *C_prev, size_t n)
+         void lstm_gatesf(float *Y, float *C, float *G, const float *C_prev, size_t n)
+         void lstm_gatesf_backward(float *dG, float *dC_prev, const float *dY, const float *dC, const float *G, const float *C, const float *C_prev, size_t n)
+         void masked_softmax(double *X, const int *lengths, size_t n, size_t nO, double scale)
+         void masked_softmaxf(float *X, const int *lengths, size_t n, size_t nO, double scale)
+         void maxout(double *best, int *which, const double *X, size_t n, size_t P)
+         void maxout_backward(double *dX, const double *dY, const int *which, size_t n, size_t P)
+         void maxout_layer_norm(double *Y, int *which, double *mean, double *var, const double *X, const double *G, const double *b, size_t n, size_t nO, size_t nP, double eps)
+         void maxoutf(float *best, int *which, const float *X, size_t n, size_t P)
+         void maxoutf_backward(float *dX, const float *dY, const int *which, size_t n, size_t P)
+         void maxoutf_layer_norm(float *Y, int *which, float *mean, float *var, const float *X, const float *G, const float *b, size_t n, size_t nO, size_t nP, float eps)
+         void ngrams(uint64_t *out, const uint64_t *keys, size_t n, size_t ngram_size)
+         void pad(double *out, const double **seqs, const int *lengths, size_t n_seqs, size_t n_pad, size_t nO, bint time_major)
+         void padf(float *out, const float **seqs, const int *lengths, size_t n_seqs, size_t n_pad, size_t nO, bint time_major)
+         void position_encode(double *out, size_t N, size_t D, double period)
+         void position_encodef(float *out, size_t N, size_t D, double period)
+         void random_normal(double *out, size_t n, double mean, double std, uint64_t seed, uint64_t offset)
+         void random_normalf(float *out, size_t n, double mean, double std, uint64_t seed, uint64_t offset)
+         void random_uniform(double *out, size_t n, double low, double high, uint64_t seed, uint64_t offset)
+         void random_uniformf(float *out, size_t n, double low, double high, uint64_t seed, uint64_t offset)
+         void residual_layer_norm(double *Y, double *S, double *mean, double *var, const double *X, const double *R, const double *G, const double *b, size_t n, size_t nO, double eps)
+         void residual_layer_normf(float *Y, float *S, float *mean, float *var, const float *X, const float *R, const float *G, const float *b, size_t n, size_t nO, float eps)
+         void sample(int *out, double *X, size_t n, size_t nO, double temperature, double top_p, uint64_t seed, uint64_t offset)
+         void samplef(int *out, float *X, size_t n, size_t nO, double temperature, double top_p, uint64_t seed, uint64_t offset)
+         void scatter_add(double *table, const int *indices, const double *values, size_t n, size_t n_idx, size_t nO)
+         void scatter_addf(float *table, const int *indices, const float *values, size_t n, size_t n_idx, size_t nO)
+         void seq2col(double *cols, const double *seq, const int *lengths, size_t n_lengths, size_t nW, size_t nI)
+         void seq2col_backward(double *dX, const double *dY, const int *lengths, size_t n_lengths, size_t nW, size_t nI)
+         void seq2colf(float *cols, const float *seq, const int *lengths, size_t n_lengths, size_t nW, size_t nI)
+         void seq2colf_backward(float *dX, const float *dY, const int *lengths, size_t n_lengths, size_t nW, size_t nI)
          void swish(double *a, size_t n)
          void swish_backward(double* a, size_t n)
          void swishf(float *a, size_t n)
          void swishf_backward(float* a, size_t n)
          void tanh(double *a, size_t n)
          void tanhf(float *a, size_t n)
+         void top_k(double *values, int *indices, const double *X, size_t n, size_t nO, size_t k)
+         void top_kf(float *values, int *indices, const float *X, size_t n, size_t nO, size_t k)
+         void unpad(double **seqs, const double *padded, const int *lengths, size_t n_seqs, size_t n_pad, size_t nO, bint time_major)
+         void unpadf(float **seqs, const float *padded, const int *lengths, size_t n_seqs, size_t n_pad, size_t nO, bint time_major)
+         void update_averages(double *ema, const double *weights, size_t n, double decay)
+         void update_averages_multi(double **ema, const double **weights, const size_t *sizes, size_t n_tensors, double decay)
+         void update_averagesf(float *ema, const float *weights, size_t n, double decay)
+         void update_averagesf_multi(float **ema, const float **weights, const size_t *sizes, size_t n_tensors, double decay)
 
 cdef extern from "simd_array/dispatch.hh":
      # Note: keep in sync with dispatch.hh
      cpdef enum InstructionSet:
          INSTRUCTION_SET_AVX,
+         INSTRUCTION_SET_AVX2,
          INSTRUCTION_SET_AVX512F,
          INSTRUCTION_SET_NEON,
          INSTRUCTION_SET_SCALAR,
          INSTRUCTION_SET_SSE2
 
      unordered_set[InstructionSet] instruction_sets() except +
+     InstructionSet best_instruction_set() except +
      unique_ptr[ArrayBase] create_array() except +
      unique_ptr[ArrayBase] create_array_for_instruction_set(InstructionSet instruction_set) except +
 
 cdef class SleefArray:
   cdef unique_ptr[ArrayBase] array
+  cdef readonly InstructionSet instruction_set
 
+  cdef void adam(self, reals_ft weights, reals_ft gradient, reals_ft mom1, reals_ft mom2, dim_t n, const AdamParams &params)
+  cdef double adam_multi(self, reals_ptrs_ft weights, reals_ptrs_ft gradients, reals_ptrs_ft mom1, reals_ptrs_ft mom2, const size_t *sizes, dim_t n_tensors, const AdamParams &params, double grad_clip)
+  cdef void adam_rows(self, reals_ft weights, reals_ft gradient, reals_ft mom1, reals_ft mom2, int *last_step, const int *rows, dim_t n_rows, dim_t nO, int step, const AdamParams &params)
+  cdef void affine(self, reals_ft Y, reals_ft X, reals_ft packed, reals_ft b, dim_t n, dim_t nO, dim_t nI, Activation activation)
+  cdef void affine_pack(self, reals_ft packed, reals_ft W, dim_t nO, dim_t nI)
+  cdef dim_t affine_packed_size(self, dim_t nO, dim_t nI)
+  cdef dim_t affinef_packed_size(self, dim_t nO, dim_t nI)
+  cdef void argmax(self, reals_ft best, int *which, reals_ft X, dim_t n, dim_t nO)
+  cdef void attention(self, reals_ft out, reals_ft Q, reals_ft K, reals_ft V, const int *lengths, dim_t n_batch, dim_t n_q, dim_t n_k, dim_t d, dim_t d_v, double scale)
+  cdef void bias_act(self, reals_ft Y, reals_ft D, reals_ft b, dim_t n, dim_t nO, Activation activation)
+  cdef void bias_act_backward(self, reals_ft dX, reals_ft db, reals_ft dY, reals_ft D, dim_t n, dim_t nO)
+  cdef double clip_gradient(self, reals_ft gradient, dim_t n, double threshold)
+  cdef void clip_gradient_multi(self, reals_ptrs_ft gradients, const size_t *sizes, dim_t n_tensors, double threshold, double *norms)
+  cdef void cosine_similarity(self, reals_ft out, reals_ft A, reals_ft B, dim_t n_a, dim_t n_b, dim_t d, double eps)
+  cdef void dropout(self, reals_ft X, dim_t n, double drop, uint64_t seed, uint64_t offset)
+  cdef void dropout_mask(self, reals_ft mask, dim_t n, double drop, uint64_t seed, uint64_t offset)
   cdef void erf(self, reals_ft a, dim_t n)
   cdef void exp(self, reals_ft a, dim_t n)
+  cdef void flatten(self, reals_ft out, reals_ptrs_ft seqs, const int *lengths, dim_t n_seqs, dim_t nO, dim_t pad)
+  cdef void gather_add(self, reals_ft out, reals_ft table, const int *indices, dim_t n, dim_t n_idx, dim_t nO)
   cdef void gelu(self, reals_ft a, dim_t n)
   cdef void gelu_backward(self, reals_ft a, dim_t n)
+  cdef void hash(self, uint32_t *out, const uint64_t *keys, dim_t n, uint32_t seed)
+  cdef void hash_embed(self, reals_ft out, int *keys, reals_ft table, const uint64_t *ids, dim_t n, dim_t nV, dim_t nO, uint32_t seed)
+  cdef void l2_normalize(self, reals_ft X, dim_t n, dim_t nO, double eps)
   cdef void logistic_cdf(self, reals_ft a, dim_t n)
+  cdef void lstm_gates(self, reals_ft Y, reals_ft C, reals_ft G, reals_ft C_prev, dim_t n)
+  cdef void lstm_gates_backward(self, reals_ft dG, reals_ft dC_prev, reals_ft dY, reals_ft dC, reals_ft G, reals_ft C, reals_ft C_prev, dim_t n)
+  cdef void masked_softmax(self, reals_ft X, const int *lengths, dim_t n, dim_t nO, double scale)
+  cdef void maxout(self, reals_ft best, int *which, reals_ft X, dim_t n, dim_t P)
+  cdef void maxout_backward(self, reals_ft dX, reals_ft dY, const int *which, dim_t n, dim_t P)
+  cdef void maxout_layer_norm(self, reals_ft Y, int *which, reals_ft mean, reals_ft var, reals_ft X, reals_ft G, reals_ft b, dim_t n, dim_t nO, dim_t nP, double eps)
+  cdef void ngrams(self, uint64_t *out, const uint64_t *keys, dim_t n, dim_t ngram_size)
+  cdef void pad(self, reals_ft out, reals_ptrs_ft seqs, const int *lengths, dim_t n_seqs, dim_t n_pad, dim_t nO, bint time_major)
+  cdef void position_encode(self, reals_ft out, dim_t N, dim_t D, double period)
+  cdef void random_normal(self, reals_ft out, dim_t n, double mean, double std, uint64_t seed, uint64_t offset)
+  cdef void random_uniform(self, reals_ft out, dim_t n, double low, double high, uint64_t seed, uint64_t offset)
+  cdef void residual_layer_norm(self, reals_ft Y, reals_ft S, reals_ft mean, reals_ft var, reals_ft X, reals_ft R, reals_ft G, reals_ft b, dim_t n, dim_t nO, double eps)
+  cdef void sample(self, int *out, reals_ft X, dim_t n, dim_t nO, double temperature, double top_p, uint64_t seed, uint64_t offset)
+  cdef void scatter_add(self, reals_ft table, const int *indices, reals_ft values, dim_t n, dim_t n_idx, dim_t nO)
+  cdef void seq2col(self, reals_ft cols, reals_ft seq, const int *lengths, dim_t n_lengths, dim_t nW, dim_t nI)
+  cdef void seq2col_backward(self, reals_ft dX, reals_ft dY, const int *lengths, dim_t n_lengths, dim_t nW, dim_t nI)
   cdef void swish(self, reals_ft a, dim_t n)
   cdef void swish_backward(self, reals_ft a, dim_t n)
   cdef void tanh(self, reals_ft a, dim_t n)
+  cdef void top_k(self, reals_ft values, int *indices, reals_ft X, dim_t n, dim_t nO, dim_t k)
+  cdef void unpad(self, reals_ptrs_ft seqs, reals_ft padded, const int *lengths, dim_t n_seqs, dim_t n_pad, dim_t nO, bint time_major)
+  cdef void update_averages(self, reals_ft ema, reals_ft weights, dim_t n, double decay)
+  cdef void update_averages_multi(self, reals_ptrs_ft ema, reals_ptrs_ft weights, const size_t *sizes, dim_t n_tensors, double decay)
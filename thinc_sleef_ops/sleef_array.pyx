@@ -3,12 +3,175 @@ from cython.operator cimport dereference as deref
 
 cdef class SleefArray:
     def __init__(self):
-        self.array.swap(create_array())
+        self.instruction_set = best_instruction_set()
+        self.array.swap(create_array_for_instruction_set(self.instruction_set))
 
     @staticmethod
     def instruction_sets():
         return instruction_sets()
 
+    cdef void adam(self, reals_ft weights, reals_ft gradient, reals_ft mom1, reals_ft mom2, dim_t n, const AdamParams &params):
+        if reals_ft is floats_t:
+            deref(self.array).adamf(weights, gradient, mom1, mom2, n, params)
+        elif reals_ft is float1d_t:
+            deref(self.array).adamf(&weights[0], &gradient[0], &mom1[0], &mom2[0], n, params)
+        elif reals_ft is doubles_t:
+            deref(self.array).adam(weights, gradient, mom1, mom2, n, params)
+        elif reals_ft is double1d_t:
+            deref(self.array).adam(&weights[0], &gradient[0], &mom1[0], &mom2[0], n, params)
+        else:
+            pass
+
+    cdef double adam_multi(self, reals_ptrs_ft weights, reals_ptrs_ft gradients, reals_ptrs_ft mom1, reals_ptrs_ft mom2, const size_t *sizes, dim_t n_tensors, const AdamParams &params, double grad_clip):
+        if reals_ptrs_ft is floats_ptrs_t:
+            return deref(self.array).adamf_multi(weights, <const float **> gradients, mom1, mom2, sizes, n_tensors, params, grad_clip)
+        else:
+            return deref(self.array).adam_multi(weights, <const double **> gradients, mom1, mom2, sizes, n_tensors, params, grad_clip)
+
+    cdef void adam_rows(self, reals_ft weights, reals_ft gradient, reals_ft mom1, reals_ft mom2, int *last_step, const int *rows, dim_t n_rows, dim_t nO, int step, const AdamParams &params):
+        if reals_ft is floats_t:
+            deref(self.array).adamf_rows(weights, gradient, mom1, mom2, last_step, rows, n_rows, nO, step, params)
+        elif reals_ft is float1d_t:
+            deref(self.array).adamf_rows(&weights[0], &gradient[0], &mom1[0], &mom2[0], last_step, rows, n_rows, nO, step, params)
+        elif reals_ft is doubles_t:
+            deref(self.array).adam_rows(weights, gradient, mom1, mom2, last_step, rows, n_rows, nO, step, params)
+        elif reals_ft is double1d_t:
+            deref(self.array).adam_rows(&weights[0], &gradient[0], &mom1[0], &mom2[0], last_step, rows, n_rows, nO, step, params)
+        else:
+            pass
+
+    cdef void affine(self, reals_ft Y, reals_ft X, reals_ft packed, reals_ft b, dim_t n, dim_t nO, dim_t nI, Activation activation):
+        if reals_ft is floats_t:
+            deref(self.array).affinef(Y, X, packed, b, n, nO, nI, activation)
+        elif reals_ft is float1d_t:
+            deref(self.array).affinef(&Y[0], &X[0], &packed[0], &b[0], n, nO, nI, activation)
+        elif reals_ft is doubles_t:
+            deref(self.array).affine(Y, X, packed, b, n, nO, nI, activation)
+        elif reals_ft is double1d_t:
+            deref(self.array).affine(&Y[0], &X[0], &packed[0], &b[0], n, nO, nI, activation)
+        else:
+            pass
+
+    cdef void affine_pack(self, reals_ft packed, reals_ft W, dim_t nO, dim_t nI):
+        if reals_ft is floats_t:
+            deref(self.array).affinef_pack(packed, W, nO, nI)
+        elif reals_ft is float1d_t:
+            deref(self.array).affinef_pack(&packed[0], &W[0], nO, nI)
+        elif reals_ft is doubles_t:
+            deref(self.array).affine_pack(packed, W, nO, nI)
+        elif reals_ft is double1d_t:
+            deref(self.array).affine_pack(&packed[0], &W[0], nO, nI)
+        else:
+            pass
+
+    cdef dim_t affine_packed_size(self, dim_t nO, dim_t nI):
+        return deref(self.array).affine_packed_size(nO, nI)
+
+    cdef dim_t affinef_packed_size(self, dim_t nO, dim_t nI):
+        return deref(self.array).affinef_packed_size(nO, nI)
+
+    cdef void argmax(self, reals_ft best, int *which, reals_ft X, dim_t n, dim_t nO):
+        if reals_ft is floats_t:
+            deref(self.array).argmaxf(best, which, X, n, nO)
+        elif reals_ft is float1d_t:
+            deref(self.array).argmaxf(&best[0], which, &X[0], n, nO)
+        elif reals_ft is doubles_t:
+            deref(self.array).argmax(best, which, X, n, nO)
+        elif reals_ft is double1d_t:
+            deref(self.array).argmax(&best[0], which, &X[0], n, nO)
+        else:
+            pass
+
+    cdef void attention(self, reals_ft out, reals_ft Q, reals_ft K, reals_ft V, const int *lengths, dim_t n_batch, dim_t n_q, dim_t n_k, dim_t d, dim_t d_v, double scale):
+        if reals_ft is floats_t:
+            deref(self.array).attentionf(out, Q, K, V, lengths, n_batch, n_q, n_k, d, d_v, scale)
+        elif reals_ft is float1d_t:
+            deref(self.array).attentionf(&out[0], &Q[0], &K[0], &V[0], lengths, n_batch, n_q, n_k, d, d_v, scale)
+        elif reals_ft is doubles_t:
+            deref(self.array).attention(out, Q, K, V, lengths, n_batch, n_q, n_k, d, d_v, scale)
+        elif reals_ft is double1d_t:
+            deref(self.array).attention(&out[0], &Q[0], &K[0], &V[0], lengths, n_batch, n_q, n_k, d, d_v, scale)
+        else:
+            pass
+
+    cdef void bias_act(self, reals_ft Y, reals_ft D, reals_ft b, dim_t n, dim_t nO, Activation activation):
+        if reals_ft is floats_t:
+            deref(self.array).bias_actf(Y, D, b, n, nO, activation)
+        elif reals_ft is float1d_t:
+            deref(self.array).bias_actf(&Y[0], &D[0] if D is not None else NULL, &b[0], n, nO, activation)
+        elif reals_ft is doubles_t:
+            deref(self.array).bias_act(Y, D, b, n, nO, activation)
+        elif reals_ft is double1d_t:
+            deref(self.array).bias_act(&Y[0], &D[0] if D is not None else NULL, &b[0], n, nO, activation)
+        else:
+            pass
+
+    cdef void bias_act_backward(self, reals_ft dX, reals_ft db, reals_ft dY, reals_ft D, dim_t n, dim_t nO):
+        if reals_ft is floats_t:
+            deref(self.array).bias_actf_backward(dX, db, dY, D, n, nO)
+        elif reals_ft is float1d_t:
+            deref(self.array).bias_actf_backward(&dX[0], &db[0], &dY[0], &D[0], n, nO)
+        elif reals_ft is doubles_t:
+            deref(self.array).bias_act_backward(dX, db, dY, D, n, nO)
+        elif reals_ft is double1d_t:
+            deref(self.array).bias_act_backward(&dX[0], &db[0], &dY[0], &D[0], n, nO)
+        else:
+            pass
+
+    cdef double clip_gradient(self, reals_ft gradient, dim_t n, double threshold):
+        if reals_ft is floats_t:
+            return deref(self.array).clip_gradientf(gradient, n, threshold)
+        elif reals_ft is float1d_t:
+            return deref(self.array).clip_gradientf(&gradient[0], n, threshold)
+        elif reals_ft is doubles_t:
+            return deref(self.array).clip_gradient(gradient, n, threshold)
+        elif reals_ft is double1d_t:
+            return deref(self.array).clip_gradient(&gradient[0], n, threshold)
+        else:
+            pass
+
+    cdef void clip_gradient_multi(self, reals_ptrs_ft gradients, const size_t *sizes, dim_t n_tensors, double threshold, double *norms):
+        if reals_ptrs_ft is floats_ptrs_t:
+            deref(self.array).clip_gradientf_multi(gradients, sizes, n_tensors, threshold, norms)
+        else:
+            deref(self.array).clip_gradient_multi(gradients, sizes, n_tensors, threshold, norms)
+
+    cdef void cosine_similarity(self, reals_ft out, reals_ft A, reals_ft B, dim_t n_a, dim_t n_b, dim_t d, double eps):
+        if reals_ft is floats_t:
+            deref(self.array).cosine_similarityf(out, A, B, n_a, n_b, d, eps)
+        elif reals_ft is float1d_t:
+            deref(self.array).cosine_similarityf(&out[0], &A[0], &B[0], n_a, n_b, d, eps)
+        elif reals_ft is doubles_t:
+            deref(self.array).cosine_similarity(out, A, B, n_a, n_b, d, eps)
+        elif reals_ft is double1d_t:
+            deref(self.array).cosine_similarity(&out[0], &A[0], &B[0], n_a, n_b, d, eps)
+        else:
+            pass
+
+    cdef void dropout(self, reals_ft X, dim_t n, double drop, uint64_t seed, uint64_t offset):
+        if reals_ft is floats_t:
+            deref(self.array).dropoutf(X, n, drop, seed, offset)
+        elif reals_ft is float1d_t:
+            deref(self.array).dropoutf(&X[0], n, drop, seed, offset)
+        elif reals_ft is doubles_t:
+            deref(self.array).dropout(X, n, drop, seed, offset)
+        elif reals_ft is double1d_t:
+            deref(self.array).dropout(&X[0], n, drop, seed, offset)
+        else:
+            pass
+
+    cdef void dropout_mask(self, reals_ft mask, dim_t n, double drop, uint64_t seed, uint64_t offset):
+        if reals_ft is floats_t:
+            deref(self.array).dropoutf_mask(mask, n, drop, seed, offset)
+        elif reals_ft is float1d_t:
+            deref(self.array).dropoutf_mask(&mask[0], n, drop, seed, offset)
+        elif reals_ft is doubles_t:
+            deref(self.array).dropout_mask(mask, n, drop, seed, offset)
+        elif reals_ft is double1d_t:
+            deref(self.array).dropout_mask(&mask[0], n, drop, seed, offset)
+        else:
+            pass
+
     cdef void erf(self, reals_ft a, dim_t n):
         if reals_ft is floats_t:
             deref(self.array).erff(a, n)
@@ -33,6 +196,26 @@ cdef class SleefArray:
         else:
             pass
 
+    cdef void flatten(self, reals_ft out, reals_ptrs_ft seqs, const int *lengths, dim_t n_seqs, dim_t nO, dim_t pad):
+        if reals_ft is floats_t and reals_ptrs_ft is floats_ptrs_t:
+            deref(self.array).flattenf(out, <const float **> seqs, lengths, n_seqs, nO, pad)
+        elif reals_ft is doubles_t and reals_ptrs_ft is doubles_ptrs_t:
+            deref(self.array).flatten(out, <const double **> seqs, lengths, n_seqs, nO, pad)
+        else:
+            pass
+
+    cdef void gather_add(self, reals_ft out, reals_ft table, const int *indices, dim_t n, dim_t n_idx, dim_t nO):
+        if reals_ft is floats_t:
+            deref(self.array).gather_addf(out, table, indices, n, n_idx, nO)
+        elif reals_ft is float1d_t:
+            deref(self.array).gather_addf(&out[0], &table[0], indices, n, n_idx, nO)
+        elif reals_ft is doubles_t:
+            deref(self.array).gather_add(out, table, indices, n, n_idx, nO)
+        elif reals_ft is double1d_t:
+            deref(self.array).gather_add(&out[0], &table[0], indices, n, n_idx, nO)
+        else:
+            pass
+
     cdef void gelu(self, reals_ft a, dim_t n):
         if reals_ft is floats_t:
             deref(self.array).geluf(a, n)
@@ -57,6 +240,33 @@ cdef class SleefArray:
         else:
             pass
 
+    cdef void hash(self, uint32_t *out, const uint64_t *keys, dim_t n, uint32_t seed):
+        deref(self.array).hash(out, keys, n, seed)
+
+    cdef void hash_embed(self, reals_ft out, int *keys, reals_ft table, const uint64_t *ids, dim_t n, dim_t nV, dim_t nO, uint32_t seed):
+        if reals_ft is floats_t:
+            deref(self.array).hash_embedf(out, keys, table, ids, n, nV, nO, seed)
+        elif reals_ft is float1d_t:
+            deref(self.array).hash_embedf(&out[0], keys, &table[0], ids, n, nV, nO, seed)
+        elif reals_ft is doubles_t:
+            deref(self.array).hash_embed(out, keys, table, ids, n, nV, nO, seed)
+        elif reals_ft is double1d_t:
+            deref(self.array).hash_embed(&out[0], keys, &table[0], ids, n, nV, nO, seed)
+        else:
+            pass
+
+    cdef void l2_normalize(self, reals_ft X, dim_t n, dim_t nO, double eps):
+        if reals_ft is floats_t:
+            deref(self.array).l2_normalizef(X, n, nO, eps)
+        elif reals_ft is float1d_t:
+            deref(self.array).l2_normalizef(&X[0], n, nO, eps)
+        elif reals_ft is doubles_t:
+            deref(self.array).l2_normalize(X, n, nO, eps)
+        elif reals_ft is double1d_t:
+            deref(self.array).l2_normalize(&X[0], n, nO, eps)
+        else:
+            pass
+
     cdef void logistic_cdf(self, reals_ft a, dim_t n):
         if reals_ft is floats_t:
             deref(self.array).logistic_cdff(a, n)
@@ -69,6 +279,185 @@ cdef class SleefArray:
         else:
             pass
 
+    cdef void lstm_gates(self, reals_ft Y, reals_ft C, reals_ft G, reals_ft C_prev, dim_t n):
+        if reals_ft is floats_t:
+            deref(self.array).lstm_gatesf(Y, C, G, C_prev, n)
+        elif reals_ft is float1d_t:
+            deref(self.array).lstm_gatesf(&Y[0], &C[0], &G[0], &C_prev[0], n)
+        elif reals_ft is doubles_t:
+            deref(self.array).lstm_gates(Y, C, G, C_prev, n)
+        elif reals_ft is double1d_t:
+            deref(self.array).lstm_gates(&Y[0], &C[0], &G[0], &C_prev[0], n)
+        else:
+            pass
+
+    cdef void lstm_gates_backward(self, reals_ft dG, reals_ft dC_prev, reals_ft dY, reals_ft dC, reals_ft G, reals_ft C, reals_ft C_prev, dim_t n):
+        if reals_ft is floats_t:
+            deref(self.array).lstm_gatesf_backward(dG, dC_prev, dY, dC, G, C, C_prev, n)
+        elif reals_ft is float1d_t:
+            deref(self.array).lstm_gatesf_backward(&dG[0], &dC_prev[0], &dY[0], &dC[0], &G[0], &C[0], &C_prev[0], n)
+        elif reals_ft is doubles_t:
+            deref(self.array).lstm_gates_backward(dG, dC_prev, dY, dC, G, C, C_prev, n)
+        elif reals_ft is double1d_t:
+            deref(self.array).lstm_gates_backward(&dG[0], &dC_prev[0], &dY[0], &dC[0], &G[0], &C[0], &C_prev[0], n)
+        else:
+            pass
+
+    cdef void masked_softmax(self, reals_ft X, const int *lengths, dim_t n, dim_t nO, double scale):
+        if reals_ft is floats_t:
+            deref(self.array).masked_softmaxf(X, lengths, n, nO, scale)
+        elif reals_ft is float1d_t:
+            deref(self.array).masked_softmaxf(&X[0], lengths, n, nO, scale)
+        elif reals_ft is doubles_t:
+            deref(self.array).masked_softmax(X, lengths, n, nO, scale)
+        elif reals_ft is double1d_t:
+            deref(self.array).masked_softmax(&X[0], lengths, n, nO, scale)
+        else:
+            pass
+
+    cdef void maxout(self, reals_ft best, int *which, reals_ft X, dim_t n, dim_t P):
+        if reals_ft is floats_t:
+            deref(self.array).maxoutf(best, which, X, n, P)
+        elif reals_ft is float1d_t:
+            deref(self.array).maxoutf(&best[0], which, &X[0], n, P)
+        elif reals_ft is doubles_t:
+            deref(self.array).maxout(best, which, X, n, P)
+        elif reals_ft is double1d_t:
+            deref(self.array).maxout(&best[0], which, &X[0], n, P)
+        else:
+            pass
+
+    cdef void maxout_backward(self, reals_ft dX, reals_ft dY, const int *which, dim_t n, dim_t P):
+        if reals_ft is floats_t:
+            deref(self.array).maxoutf_backward(dX, dY, which, n, P)
+        elif reals_ft is float1d_t:
+            deref(self.array).maxoutf_backward(&dX[0], &dY[0], which, n, P)
+        elif reals_ft is doubles_t:
+            deref(self.array).maxout_backward(dX, dY, which, n, P)
+        elif reals_ft is double1d_t:
+            deref(self.array).maxout_backward(&dX[0], &dY[0], which, n, P)
+        else:
+            pass
+
+    cdef void maxout_layer_norm(self, reals_ft Y, int *which, reals_ft mean, reals_ft var, reals_ft X, reals_ft G, reals_ft b, dim_t n, dim_t nO, dim_t nP, double eps):
+        if reals_ft is floats_t:
+            deref(self.array).maxoutf_layer_norm(Y, which, mean, var, X, G, b, n, nO, nP, eps)
+        elif reals_ft is float1d_t:
+            deref(self.array).maxoutf_layer_norm(&Y[0], which, &mean[0], &var[0], &X[0], &G[0], &b[0], n, nO, nP, eps)
+        elif reals_ft is doubles_t:
+            deref(self.array).maxout_layer_norm(Y, which, mean, var, X, G, b, n, nO, nP, eps)
+        elif reals_ft is double1d_t:
+            deref(self.array).maxout_layer_norm(&Y[0], which, &mean[0], &var[0], &X[0], &G[0], &b[0], n, nO, nP, eps)
+        else:
+            pass
+
+    cdef void ngrams(self, uint64_t *out, const uint64_t *keys, dim_t n, dim_t ngram_size):
+        deref(self.array).ngrams(out, keys, n, ngram_size)
+
+    cdef void pad(self, reals_ft out, reals_ptrs_ft seqs, const int *lengths, dim_t n_seqs, dim_t n_pad, dim_t nO, bint time_major):
+        if reals_ft is floats_t and reals_ptrs_ft is floats_ptrs_t:
+            deref(self.array).padf(out, <const float **> seqs, lengths, n_seqs, n_pad, nO, time_major)
+        elif reals_ft is doubles_t and reals_ptrs_ft is doubles_ptrs_t:
+            deref(self.array).pad(out, <const double **> seqs, lengths, n_seqs, n_pad, nO, time_major)
+        else:
+            pass
+
+    cdef void position_encode(self, reals_ft out, dim_t N, dim_t D, double period):
+        if reals_ft is floats_t:
+            deref(self.array).position_encodef(out, N, D, period)
+        elif reals_ft is float1d_t:
+            deref(self.array).position_encodef(&out[0], N, D, period)
+        elif reals_ft is doubles_t:
+            deref(self.array).position_encode(out, N, D, period)
+        elif reals_ft is double1d_t:
+            deref(self.array).position_encode(&out[0], N, D, period)
+        else:
+            pass
+
+    cdef void random_normal(self, reals_ft out, dim_t n, double mean, double std, uint64_t seed, uint64_t offset):
+        if reals_ft is floats_t:
+            deref(self.array).random_normalf(out, n, mean, std, seed, offset)
+        elif reals_ft is float1d_t:
+            deref(self.array).random_normalf(&out[0], n, mean, std, seed, offset)
+        elif reals_ft is doubles_t:
+            deref(self.array).random_normal(out, n, mean, std, seed, offset)
+        elif reals_ft is double1d_t:
+            deref(self.array).random_normal(&out[0], n, mean, std, seed, offset)
+        else:
+            pass
+
+    cdef void random_uniform(self, reals_ft out, dim_t n, double low, double high, uint64_t seed, uint64_t offset):
+        if reals_ft is floats_t:
+            deref(self.array).random_uniformf(out, n, low, high, seed, offset)
+        elif reals_ft is float1d_t:
+            deref(self.array).random_uniformf(&out[0], n, low, high, seed, offset)
+        elif reals_ft is doubles_t:
+            deref(self.array).random_uniform(out, n, low, high, seed, offset)
+        elif reals_ft is double1d_t:
+            deref(self.array).random_uniform(&out[0], n, low, high, seed, offset)
+        else:
+            pass
+
+    cdef void residual_layer_norm(self, reals_ft Y, reals_ft S, reals_ft mean, reals_ft var, reals_ft X, reals_ft R, reals_ft G, reals_ft b, dim_t n, dim_t nO, double eps):
+        if reals_ft is floats_t:
+            deref(self.array).residual_layer_normf(Y, S, mean, var, X, R, G, b, n, nO, eps)
+        elif reals_ft is float1d_t:
+            deref(self.array).residual_layer_normf(&Y[0], &S[0] if S is not None else NULL, &mean[0], &var[0], &X[0], &R[0], &G[0], &b[0], n, nO, eps)
+        elif reals_ft is doubles_t:
+            deref(self.array).residual_layer_norm(Y, S, mean, var, X, R, G, b, n, nO, eps)
+        elif reals_ft is double1d_t:
+            deref(self.array).residual_layer_norm(&Y[0], &S[0] if S is not None else NULL, &mean[0], &var[0], &X[0], &R[0], &G[0], &b[0], n, nO, eps)
+        else:
+            pass
+
+    cdef void sample(self, int *out, reals_ft X, dim_t n, dim_t nO, double temperature, double top_p, uint64_t seed, uint64_t offset):
+        if reals_ft is floats_t:
+            deref(self.array).samplef(out, X, n, nO, temperature, top_p, seed, offset)
+        elif reals_ft is float1d_t:
+            deref(self.array).samplef(out, &X[0], n, nO, temperature, top_p, seed, offset)
+        elif reals_ft is doubles_t:
+            deref(self.array).sample(out, X, n, nO, temperature, top_p, seed, offset)
+        elif reals_ft is double1d_t:
+            deref(self.array).sample(out, &X[0], n, nO, temperature, top_p, seed, offset)
+        else:
+            pass
+
+    cdef void scatter_add(self, reals_ft table, const int *indices, reals_ft values, dim_t n, dim_t n_idx, dim_t nO):
+        if reals_ft is floats_t:
+            deref(self.array).scatter_addf(table, indices, values, n, n_idx, nO)
+        elif reals_ft is float1d_t:
+            deref(self.array).scatter_addf(&table[0], indices, &values[0], n, n_idx, nO)
+        elif reals_ft is doubles_t:
+            deref(self.array).scatter_add(table, indices, values, n, n_idx, nO)
+        elif reals_ft is double1d_t:
+            deref(self.array).scatter_add(&table[0], indices, &values[0], n, n_idx, nO)
+        else:
+            pass
+
+    cdef void seq2col(self, reals_ft cols, reals_ft seq, const int *lengths, dim_t n_lengths, dim_t nW, dim_t nI):
+        if reals_ft is floats_t:
+            deref(self.array).seq2colf(cols, seq, lengths, n_lengths, nW, nI)
+        elif reals_ft is float1d_t:
+            deref(self.array).seq2colf(&cols[0], &seq[0], lengths, n_lengths, nW, nI)
+        elif reals_ft is doubles_t:
+            deref(self.array).seq2col(cols, seq, lengths, n_lengths, nW, nI)
+        elif reals_ft is double1d_t:
+            deref(self.array).seq2col(&cols[0], &seq[0], lengths, n_lengths, nW, nI)
+        else:
+            pass
+
+    cdef void seq2col_backward(self, reals_ft dX, reals_ft dY, const int *lengths, dim_t n_lengths, dim_t nW, dim_t nI):
+        if reals_ft is floats_t:
+            deref(self.array).seq2colf_backward(dX, dY, lengths, n_lengths, nW, nI)
+        elif reals_ft is float1d_t:
+            deref(self.array).seq2colf_backward(&dX[0], &dY[0], lengths, n_lengths, nW, nI)
+        elif reals_ft is doubles_t:
+            deref(self.array).seq2col_backward(dX, dY, lengths, n_lengths, nW, nI)
+        elif reals_ft is double1d_t:
+            deref(self.array).seq2col_backward(&dX[0], &dY[0], lengths, n_lengths, nW, nI)
+        else:
+            pass
+
     cdef void swish(self, reals_ft a, dim_t n):
         if reals_ft is floats_t:
             deref(self.array).swishf(a, n)
@@ -105,8 +494,47 @@ cdef class SleefArray:
         else:
             pass
 
+    cdef void top_k(self, reals_ft values, int *indices, reals_ft X, dim_t n, dim_t nO, dim_t k):
+        if reals_ft is floats_t:
+            deref(self.array).top_kf(values, indices, X, n, nO, k)
+        elif reals_ft is float1d_t:
+            deref(self.array).top_kf(&values[0], indices, &X[0], n, nO, k)
+        elif reals_ft is doubles_t:
+            deref(self.array).top_k(values, indices, X, n, nO, k)
+        elif reals_ft is double1d_t:
+            deref(self.array).top_k(&values[0], indices, &X[0], n, nO, k)
+        else:
+            pass
+
+    cdef void unpad(self, reals_ptrs_ft seqs, reals_ft padded, const int *lengths, dim_t n_seqs, dim_t n_pad, dim_t nO, bint time_major):
+        if reals_ft is floats_t and reals_ptrs_ft is floats_ptrs_t:
+            deref(self.array).unpadf(seqs, padded, lengths, n_seqs, n_pad, nO, time_major)
+        elif reals_ft is doubles_t and reals_ptrs_ft is doubles_ptrs_t:
+            deref(self.array).unpad(seqs, padded, lengths, n_seqs, n_pad, nO, time_major)
+        else:
+            pass
+
+    cdef void update_averages(self, reals_ft ema, reals_ft weights, dim_t n, double decay):
+        if reals_ft is floats_t:
+            deref(self.array).update_averagesf(ema, weights, n, decay)
+        elif reals_ft is float1d_t:
+            deref(self.array).update_averagesf(&ema[0], &weights[0], n, decay)
+        elif reals_ft is doubles_t:
+            deref(self.array).update_averages(ema, weights, n, decay)
+        elif reals_ft is double1d_t:
+            deref(self.array).update_averages(&ema[0], &weights[0], n, decay)
+        else:
+            pass
+
+    cdef void update_averages_multi(self, reals_ptrs_ft ema, reals_ptrs_ft weights, const size_t *sizes, dim_t n_tensors, double decay):
+        if reals_ptrs_ft is floats_ptrs_t:
+            deref(self.array).update_averagesf_multi(ema, <const float **> weights, sizes, n_tensors, decay)
+        else:
+            deref(self.array).update_averages_multi(ema, <const double **> weights, sizes, n_tensors, decay)
+
 @contextmanager
 def with_cpu_feature(InstructionSet feature):
     array = SleefArray()
     array.array.swap(create_array_for_instruction_set(feature))
+    array.instruction_set = feature
     yield array
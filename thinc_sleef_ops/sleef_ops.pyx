@@ -3,9 +3,12 @@
 # cython: profile=True
 
 from contextlib import contextmanager
+from libc.stdint cimport uint32_t, uint64_t
+from libcpp.vector cimport vector
 cimport numpy as np
 import numpy as np
 from thinc.api import Ops
+from thinc.types import Padded
 
 try:
     from thinc_apple_ops import AppleOps
@@ -13,17 +16,585 @@ try:
 except ImportError:
     ops_superclass = Ops
 
-from .sleef_array cimport InstructionSet, SleefArray
+from .sleef_array cimport Activation, AdamParams, InstructionSet, SleefArray
+from .sleef_array import Activation as PyActivation
 from .sleef_array import with_cpu_feature as sleef_with_cpu_feature
 
+_ACTIVATIONS = {
+    "gelu": PyActivation.ACTIVATION_GELU,
+    "identity": PyActivation.ACTIVATION_IDENTITY,
+    "relu": PyActivation.ACTIVATION_RELU,
+    "sigmoid": PyActivation.ACTIVATION_SIGMOID,
+    "swish": PyActivation.ACTIVATION_SWISH,
+    "tanh": PyActivation.ACTIVATION_TANH,
+}
+
+# Largest k that top_k selects with the kernel.
+_TOP_K_MAX = 32
+
+class PackedWeights:
+    """Weights of an affine layer, packed into panels for the affine kernel.
+    The packed layout depends on the instruction set, so packed weights can
+    only be used with SleefOps instances for the instruction set that packed
+    them."""
+
+    def __init__(self, np.ndarray data, int nO, int nI, InstructionSet instruction_set):
+        self.data = data
+        self.nO = nO
+        self.nI = nI
+        self.instruction_set = instruction_set
+
+    @property
+    def dtype(self):
+        return self.data.dtype
+
+
 class SleefOps(ops_superclass):
     def __init__(self):
         self._array = SleefArray()
+        self._position_encodings = {}
 
     @staticmethod
     def instruction_sets():
         return SleefArray.instruction_sets()
 
+    def adam(self, np.ndarray weights, np.ndarray gradient, np.ndarray mom1, np.ndarray mom2,
+             double beta1, double beta2, double eps, double learn_rate, double mod_rate=1.0,
+             *, double grad_scale=1.0, double L2=0.0, double weight_decay=0.0):
+        """Apply an Adam update to weights, mom1 and mom2 in-place, in a
+        single pass over the arrays. Besides thinc's Ops.adam arguments, the
+        gradient can be scaled by grad_scale (e.g. for gradient clipping), an
+        L2 penalty can be added to the gradient and decoupled weight decay
+        can be applied to the updated weights."""
+        cdef SleefArray array = self._array
+
+        _check_adam_arrays(weights, gradient, mom1, mom2, weights.dtype)
+        cdef AdamParams params = _adam_params(beta1, beta2, eps, learn_rate, mod_rate, grad_scale, L2, weight_decay)
+
+        cdef size_t n = weights.size
+        if weights.dtype == np.float32:
+            array.adam(<float *> weights.data, <float *> gradient.data, <float *> mom1.data,
+                <float *> mom2.data, n, params)
+        elif weights.dtype == np.float64:
+            array.adam(<double *> weights.data, <double *> gradient.data, <double *> mom1.data,
+                <double *> mom2.data, n, params)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return weights, gradient, mom1, mom2
+
+    def adam_multi(self, weights, gradients, mom1, mom2,
+                   double beta1, double beta2, double eps, double learn_rate, double mod_rate=1.0,
+                   *, double grad_clip=0.0, double L2=0.0, double weight_decay=0.0):
+        """Apply an Adam update to a list of parameters in-place, see adam.
+        If grad_clip is positive, the gradients are clipped by their global
+        norm first. The norm and the updates are computed in two sweeps over
+        all parameters, with a single call into the kernel. Returns the
+        global gradient norm before clipping."""
+        cdef SleefArray array = self._array
+
+        cdef size_t n_tensors = len(weights)
+        if len(gradients) != n_tensors or len(mom1) != n_tensors or len(mom2) != n_tensors:
+            raise ValueError("Number of weights, gradients and moments must be equal")
+        if n_tensors == 0:
+            return 0.0
+        dtype = weights[0].dtype
+
+        cdef vector[char *] weights_, gradients_, mom1_, mom2_
+        cdef vector[size_t] sizes
+        cdef np.ndarray w, g, m1, m2
+        for w, g, m1, m2 in zip(weights, gradients, mom1, mom2):
+            _check_adam_arrays(w, g, m1, m2, dtype)
+            weights_.push_back(w.data)
+            gradients_.push_back(g.data)
+            mom1_.push_back(m1.data)
+            mom2_.push_back(m2.data)
+            sizes.push_back(w.size)
+
+        cdef AdamParams params = _adam_params(beta1, beta2, eps, learn_rate, mod_rate, 1.0, L2, weight_decay)
+
+        if dtype == np.float32:
+            return array.adam_multi(<float **> weights_.data(), <float **> gradients_.data(),
+                <float **> mom1_.data(), <float **> mom2_.data(), sizes.data(), n_tensors, params, grad_clip)
+        elif dtype == np.float64:
+            return array.adam_multi(<double **> weights_.data(), <double **> gradients_.data(),
+                <double **> mom1_.data(), <double **> mom2_.data(), sizes.data(), n_tensors, params, grad_clip)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+    def adam_rows(self, np.ndarray weights, np.ndarray gradient, np.ndarray mom1, np.ndarray mom2,
+                  rows, np.ndarray last_step, int step,
+                  double beta1, double beta2, double eps, double learn_rate, double mod_rate=1.0,
+                  *, double grad_scale=1.0, double L2=0.0, double weight_decay=0.0):
+        """Apply an Adam update in-place to the given rows of the (n, nO)
+        table weights, see adam. gradient holds the gradient of each row in
+        rows, rows must be unique. last_step is an int32 array with the last
+        step in which each row of the table was updated, initially zero. The
+        moments of a row are decayed lazily for the steps in which it was not
+        updated; its weights are not changed in those steps."""
+        cdef SleefArray array = self._array
+
+        if weights.ndim != 2:
+            raise ValueError(f"adam_rows requires table of dimensionality 2, was {weights.ndim}")
+        cdef size_t nO = weights.shape[1]
+        cdef np.ndarray rows_ = np.ascontiguousarray(rows, dtype=np.int32)
+        cdef size_t n_rows = rows_.shape[0]
+        if gradient.ndim != 2 or gradient.shape[0] != n_rows or gradient.shape[1] != nO:
+            raise ValueError(f"Gradient must have shape ({n_rows}, {nO})")
+        if n_rows != 0 and (rows_.min() < 0 or rows_.max() >= weights.shape[0]):
+            raise ValueError("Row index out of bounds")
+        if np.unique(rows_).shape[0] != n_rows:
+            raise ValueError("Rows must be unique")
+        if last_step.dtype != np.int32 or last_step.size != weights.shape[0] or not last_step.flags["C_CONTIGUOUS"]:
+            raise ValueError(f"last_step must be a contiguous int32 array with {weights.shape[0]} elements")
+        if mom1.size != weights.size or mom2.size != weights.size:
+            raise ValueError("Moments must have the same size as the weights")
+        for a in (weights, mom1, mom2):
+            if a.dtype != weights.dtype:
+                raise ValueError(f"Array of dtype {a.dtype} does not match weights of dtype {weights.dtype}")
+            if not a.flags["C_CONTIGUOUS"]:
+                raise ValueError("Cannot apply operation in-place, array is not C-contiguous")
+
+        gradient = np.ascontiguousarray(gradient, dtype=weights.dtype)
+        cdef AdamParams params = _adam_params(beta1, beta2, eps, learn_rate, mod_rate, grad_scale, L2, weight_decay)
+
+        if weights.dtype == np.float32:
+            array.adam_rows(<float *> weights.data, <float *> gradient.data, <float *> mom1.data,
+                <float *> mom2.data, <int *> last_step.data, <int *> rows_.data, n_rows, nO, step, params)
+        elif weights.dtype == np.float64:
+            array.adam_rows(<double *> weights.data, <double *> gradient.data, <double *> mom1.data,
+                <double *> mom2.data, <int *> last_step.data, <int *> rows_.data, n_rows, nO, step, params)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return weights, mom1, mom2
+
+    def affine(self, np.ndarray X, W, np.ndarray b, *, activation: str="identity"):
+        """Compute act(X @ W.T + b), with the activation applied while the
+        output tile is still in registers. W is either a (nO, nI) array,
+        which is packed on every call, or weights packed with pack_weights.
+        Packing is not cached implicitly, since optimizers update weights
+        in-place, so pack weights that are reused across calls explicitly.
+        Supported activations are gelu, identity, relu, sigmoid, swish and
+        tanh."""
+        cdef SleefArray array = self._array
+
+        if X.ndim != 2:
+            raise ValueError(f"affine requires input array of dimensionality 2, was {X.ndim}")
+        if activation not in _ACTIVATIONS:
+            raise ValueError(f"Unknown activation: {activation}")
+        cdef Activation act = _ACTIVATIONS[activation]
+
+        packed = W if isinstance(W, PackedWeights) else self.pack_weights(W)
+        if packed.instruction_set != array.instruction_set:
+            raise ValueError("Packed weights were packed for another instruction set")
+
+        cdef size_t n = X.shape[0]
+        cdef size_t nO = packed.nO
+        cdef size_t nI = packed.nI
+        if X.shape[1] != nI:
+            raise ValueError(f"Input width {X.shape[1]} does not match the weights' input width {nI}")
+        if b.size != nO:
+            raise ValueError(f"Bias must have {nO} elements")
+        if X.dtype != packed.dtype:
+            raise ValueError(f"Input dtype {X.dtype} does not match the weights' dtype {packed.dtype}")
+
+        X = self.as_contig(X)
+        b = np.ascontiguousarray(b, dtype=X.dtype)
+        cdef np.ndarray packed_data = packed.data
+        cdef np.ndarray Y = np.empty((n, nO), dtype=X.dtype)
+
+        if X.dtype == np.float32:
+            array.affine(<float *> Y.data, <float *> X.data, <float *> packed_data.data, <float *> b.data,
+                n, nO, nI, act)
+        elif X.dtype == np.float64:
+            array.affine(<double *> Y.data, <double *> X.data, <double *> packed_data.data, <double *> b.data,
+                n, nO, nI, act)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return Y
+
+    def argmax(self, np.ndarray X):
+        """The maximum of each row of X along the last axis and its index.
+        Ties resolve to the first index and rows with NaN return their
+        first NaN, like numpy.argmax."""
+        cdef SleefArray array = self._array
+
+        if X.ndim < 1 or X.shape[X.ndim - 1] == 0:
+            raise ValueError("argmax requires a non-empty last axis")
+
+        cdef size_t nO = X.shape[X.ndim - 1]
+        cdef size_t n = X.size // nO
+
+        X = self.as_contig(X)
+        batch_shape = (<object> X).shape[:-1]
+        cdef np.ndarray best = np.empty(batch_shape, dtype=X.dtype)
+        cdef np.ndarray which = np.empty(batch_shape, dtype=np.int32)
+
+        if X.dtype == np.float32:
+            array.argmax(<float *> best.data, <int *> which.data, <float *> X.data, n, nO)
+        elif X.dtype == np.float64:
+            array.argmax(<double *> best.data, <int *> which.data, <double *> X.data, n, nO)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return best, which
+
+    def attention(self, np.ndarray Q, np.ndarray K, np.ndarray V, *, lengths=None, scale=None):
+        """Scaled dot-product attention softmax(scale * Q K^T) V over the last
+        two axes. Keys are processed in tiles with an online softmax, so the
+        score matrix is never materialized. Q has shape (..., n_q, d), K has
+        shape (..., n_k, d) and V has shape (..., n_k, d_v), with equal
+        leading axes. lengths is the number of valid keys, broadcast to the
+        leading axes. scale defaults to 1 / sqrt(d)."""
+        cdef SleefArray array = self._array
+
+        if Q.ndim < 2 or K.ndim != Q.ndim or V.ndim != Q.ndim:
+            raise ValueError("Queries, keys and values must have the same dimensionality of at least 2")
+        batch_shape = (<object> Q).shape[:-2]
+        if (<object> K).shape[:-2] != batch_shape or (<object> V).shape[:-2] != batch_shape:
+            raise ValueError("Leading axes of queries, keys and values must match")
+        if K.shape[K.ndim - 1] != Q.shape[Q.ndim - 1]:
+            raise ValueError("Queries and keys must have the same width")
+        if Q.shape[Q.ndim - 1] == 0:
+            raise ValueError("Queries and keys must have a non-empty width")
+        if V.shape[V.ndim - 2] != K.shape[K.ndim - 2]:
+            raise ValueError("Number of values must match the number of keys")
+
+        cdef size_t n_q = Q.shape[Q.ndim - 2]
+        cdef size_t n_k = K.shape[K.ndim - 2]
+        cdef size_t d = Q.shape[Q.ndim - 1]
+        cdef size_t d_v = V.shape[V.ndim - 1]
+        cdef size_t n_batch = int(np.prod(batch_shape))
+        cdef double scale_ = 1.0 / np.sqrt(d) if scale is None else scale
+        if scale_ <= 0:
+            raise ValueError(f"Scale must be positive, was {scale_}")
+
+        Q = self.as_contig(Q)
+        K = np.ascontiguousarray(K, dtype=Q.dtype)
+        V = np.ascontiguousarray(V, dtype=Q.dtype)
+        cdef np.ndarray lengths_ = None
+        if lengths is not None:
+            lengths_ = np.ascontiguousarray(np.broadcast_to(lengths, batch_shape), dtype=np.int32)
+        cdef np.ndarray out = np.empty(batch_shape + (n_q, d_v), dtype=Q.dtype)
+
+        if Q.dtype == np.float32:
+            array.attention(<float *> out.data, <float *> Q.data, <float *> K.data, <float *> V.data,
+                <int *> lengths_.data if lengths_ is not None else NULL, n_batch, n_q, n_k, d, d_v, scale_)
+        elif Q.dtype == np.float64:
+            array.attention(<double *> out.data, <double *> Q.data, <double *> K.data, <double *> V.data,
+                <int *> lengths_.data if lengths_ is not None else NULL, n_batch, n_q, n_k, d, d_v, scale_)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return out
+
+    def backprop_bias_act(self, np.ndarray dY, np.ndarray D, *, db=None, inplace: bool=False):
+        """Backpropagate through bias_act, given the derivative D saved by
+        bias_act. Returns the gradient of the activation input dY * D and
+        the bias gradient, which is computed in the same pass over the
+        gradient. If db is given, the bias gradient is added to it in-place."""
+        cdef SleefArray array = self._array
+
+        if dY.ndim != 2:
+            raise ValueError(f"backprop_bias_act requires gradient array of dimensionality 2, was {dY.ndim}")
+        if D.ndim != 2:
+            raise ValueError(f"backprop_bias_act requires derivative array of dimensionality 2, was {D.ndim}")
+        if D.shape[0] != dY.shape[0] or D.shape[1] != dY.shape[1]:
+            raise ValueError("Shape of the derivative must match the shape of the gradient")
+
+        cdef size_t n = dY.shape[0]
+        cdef size_t nO = dY.shape[1]
+
+        cdef np.ndarray dX
+        cdef np.ndarray db_
+        if db is None:
+            db_ = np.zeros(nO, dtype=dY.dtype)
+        else:
+            db_ = db
+            if db_.size != nO or db_.dtype != dY.dtype or not db_.flags["C_CONTIGUOUS"]:
+                raise ValueError(f"Bias gradient must be a contiguous {dY.dtype} array with {nO} elements")
+
+        if inplace:
+            if not dY.flags["C_CONTIGUOUS"]:
+                raise ValueError("Cannot apply operation in-place, array is not C-contiguous")
+            dX = dY
+        else:
+            dY = self.as_contig(dY)
+            dX = np.empty((n, nO), dtype=dY.dtype)
+        D = np.ascontiguousarray(D, dtype=dY.dtype)
+
+        if dY.dtype == np.float32:
+            array.bias_act_backward(<float *> dX.data, <float *> db_.data, <float *> dY.data, <float *> D.data, n, nO)
+        elif dY.dtype == np.float64:
+            array.bias_act_backward(<double *> dX.data, <double *> db_.data, <double *> dY.data, <double *> D.data, n, nO)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return dX, db_
+
+    def backprop_gather_add(self, np.ndarray dY, indices, size_t n_rows):
+        """Backpropagate through gather_add into a table with n_rows rows.
+        Every row of dY is added to the table rows it was gathered from, in a
+        single call."""
+        cdef SleefArray array = self._array
+
+        if dY.ndim != 2:
+            raise ValueError(f"backprop_gather_add requires gradient array of dimensionality 2, was {dY.ndim}")
+        cdef np.ndarray idx = _table_indices(indices, n_rows)
+        if idx.ndim != 2 or idx.shape[0] != dY.shape[0]:
+            raise ValueError("Indices must be a 2D array with one row per gradient row")
+
+        cdef size_t n = idx.shape[0]
+        cdef size_t n_idx = idx.shape[1]
+        cdef size_t nO = dY.shape[1]
+        dY = self.as_contig(dY)
+        cdef np.ndarray dE = np.zeros((n_rows, nO), dtype=dY.dtype)
+
+        if dY.dtype == np.float32:
+            array.scatter_add(<float *> dE.data, <int *> idx.data, <float *> dY.data, n, n_idx, nO)
+        elif dY.dtype == np.float64:
+            array.scatter_add(<double *> dE.data, <int *> idx.data, <double *> dY.data, n, n_idx, nO)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return dE
+
+    def backprop_lstm_gates(self, np.ndarray dY, np.ndarray dC, np.ndarray G, np.ndarray C, np.ndarray C_prev):
+        """Backpropagate through lstm_gates, given the activated gates G and
+        cell state C that it returned. dC is the gradient of the cell state
+        from the next timestep. Returns the gradient of the pre-activation
+        gates and of the previous cell state."""
+        cdef SleefArray array = self._array
+
+        for a in (dY, dC, G, C, C_prev):
+            if a.ndim != 2:
+                raise ValueError(f"backprop_lstm_gates requires arrays of dimensionality 2, was {a.ndim}")
+        for a in (dY, dC, C):
+            if a.shape[0] != C_prev.shape[0] or a.shape[1] != C_prev.shape[1]:
+                raise ValueError("Shapes of the output, cell and gradient arrays must match")
+        if G.shape[0] != C_prev.shape[0] or G.shape[1] != C_prev.shape[1] * 4:
+            raise ValueError("Gate array must have four gates per hidden unit")
+
+        cdef size_t n = C_prev.size
+        dtype = C_prev.dtype
+        C_prev = self.as_contig(C_prev)
+        dY = np.ascontiguousarray(dY, dtype=dtype)
+        dC = np.ascontiguousarray(dC, dtype=dtype)
+        G = np.ascontiguousarray(G, dtype=dtype)
+        C = np.ascontiguousarray(C, dtype=dtype)
+        cdef np.ndarray dG = np.empty_like(G)
+        cdef np.ndarray dC_prev = np.empty_like(C_prev)
+
+        if dtype == np.float32:
+            array.lstm_gates_backward(<float *> dG.data, <float *> dC_prev.data, <float *> dY.data,
+                <float *> dC.data, <float *> G.data, <float *> C.data, <float *> C_prev.data, n)
+        elif dtype == np.float64:
+            array.lstm_gates_backward(<double *> dG.data, <double *> dC_prev.data, <double *> dY.data,
+                <double *> dC.data, <double *> G.data, <double *> C.data, <double *> C_prev.data, n)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return dG, dC_prev
+
+    def backprop_maxout(self, np.ndarray dY, which, int P):
+        cdef SleefArray array = self._array
+
+        if dY.ndim != 2:
+            raise ValueError(f"backprop_maxout requires gradient array of dimensionality 2, was {dY.ndim}")
+        if P <= 0:
+            raise ValueError(f"Number of maxout pieces must be positive, was {P}")
+
+        cdef np.ndarray which_ = np.ascontiguousarray(which, dtype=np.int32)
+        if which_.ndim != 2 or which_.shape[0] != dY.shape[0] or which_.shape[1] != dY.shape[1]:
+            raise ValueError("Shape of which must match the shape of the gradient")
+
+        cdef size_t n = dY.shape[0] * dY.shape[1]
+        dY = self.as_contig(dY)
+        cdef np.ndarray dX = np.empty((dY.shape[0], dY.shape[1], P), dtype=dY.dtype)
+
+        if dY.dtype == np.float32:
+            array.maxout_backward(<float *> dX.data, <float *> dY.data, <int *> which_.data, n, P)
+        elif dY.dtype == np.float64:
+            array.maxout_backward(<double *> dX.data, <double *> dY.data, <int *> which_.data, n, P)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return dX
+
+    def backprop_seq2col(self, np.ndarray dY, int nW, *, lengths=None):
+        cdef SleefArray array = self._array
+
+        if dY.ndim != 2:
+            raise ValueError(f"backprop_seq2col requires gradient array of dimensionality 2, was {dY.ndim}")
+        if nW < 0:
+            raise ValueError(f"Window size must be non-negative, was {nW}")
+
+        cdef size_t nF = 2 * nW + 1
+        if dY.shape[1] % nF != 0:
+            raise ValueError(f"Gradient width {dY.shape[1]} is not a multiple of the window size {nF}")
+        cdef size_t nI = dY.shape[1] // nF
+
+        cdef np.ndarray lengths_ = self._seq2col_lengths(lengths, dY.shape[0])
+        dY = self.as_contig(dY)
+        cdef np.ndarray dX = np.empty((dY.shape[0], nI), dtype=dY.dtype)
+
+        if dY.dtype == np.float32:
+            array.seq2col_backward(<float *> dX.data, <float *> dY.data, <int *> lengths_.data, lengths_.shape[0], nW, nI)
+        elif dY.dtype == np.float64:
+            array.seq2col_backward(<double *> dX.data, <double *> dY.data, <int *> lengths_.data, lengths_.shape[0], nW, nI)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return dX
+
+    def bias_act(self, np.ndarray Y, np.ndarray b, activation: str="gelu", *, inplace: bool=False, save_derivative: bool=False):
+        """Add the bias b to each row of Y and apply an activation. Returns
+        the output and the derivative of the activation with respect to its
+        input (None unless save_derivative is set). Supported activations
+        are gelu, identity, relu, sigmoid, swish and tanh."""
+        cdef SleefArray array = self._array
+
+        if Y.ndim != 2:
+            raise ValueError(f"bias_act requires array of dimensionality 2, was {Y.ndim}")
+        if b.size != Y.shape[1]:
+            raise ValueError(f"Bias must have {Y.shape[1]} elements")
+        if activation not in _ACTIVATIONS:
+            raise ValueError(f"Unknown activation: {activation}")
+        cdef Activation act = _ACTIVATIONS[activation]
+
+        if inplace:
+            if not Y.flags["C_CONTIGUOUS"]:
+                raise ValueError("Cannot apply operation in-place, array is not C-contiguous")
+        else:
+            Y = Y.copy()
+
+        cdef size_t n = Y.shape[0]
+        cdef size_t nO = Y.shape[1]
+        b = np.ascontiguousarray(b, dtype=Y.dtype)
+        cdef np.ndarray D = np.empty((n, nO), dtype=Y.dtype) if save_derivative else None
+
+        if Y.dtype == np.float32:
+            array.bias_act(<float *> Y.data, <float *> D.data if D is not None else <float *> NULL,
+                <float *> b.data, n, nO, act)
+        elif Y.dtype == np.float64:
+            array.bias_act(<double *> Y.data, <double *> D.data if D is not None else <double *> NULL,
+                <double *> b.data, n, nO, act)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return Y, D
+
+    def clip_gradient(self, np.ndarray gradient, double threshold):
+        """Rescale the gradient in-place to have norm threshold, if its norm
+        is at least threshold. Gradients that are not C-contiguous float32 or
+        float64 arrays are handled by the superclass."""
+        cdef SleefArray array = self._array
+
+        if not gradient.flags["C_CONTIGUOUS"]:
+            return super().clip_gradient(gradient, threshold)
+
+        cdef size_t n = gradient.size
+        if gradient.dtype == np.float32:
+            array.clip_gradient(<float *> gradient.data, n, threshold)
+        elif gradient.dtype == np.float64:
+            array.clip_gradient(<double *> gradient.data, n, threshold)
+        else:
+            return super().clip_gradient(gradient, threshold)
+
+        return gradient
+
+    def clip_gradient_multi(self, gradients, double threshold):
+        """Clip each gradient of a list in-place, see clip_gradient. Returns
+        the norms of the gradients before clipping."""
+        cdef SleefArray array = self._array
+
+        cdef size_t n_tensors = len(gradients)
+        cdef np.ndarray norms = np.empty(n_tensors, dtype=np.float64)
+        if n_tensors == 0:
+            return norms
+        dtype = gradients[0].dtype
+
+        cdef vector[char *] gradients_
+        cdef vector[size_t] sizes
+        cdef np.ndarray g
+        for g in gradients:
+            if g.dtype != dtype:
+                raise ValueError(f"Array of dtype {g.dtype} does not match dtype {dtype}")
+            if not g.flags["C_CONTIGUOUS"]:
+                raise ValueError("Cannot apply operation in-place, array is not C-contiguous")
+            gradients_.push_back(g.data)
+            sizes.push_back(g.size)
+
+        if dtype == np.float32:
+            array.clip_gradient_multi(<float **> gradients_.data(), sizes.data(), n_tensors,
+                threshold, <double *> norms.data)
+        elif dtype == np.float64:
+            array.clip_gradient_multi(<double **> gradients_.data(), sizes.data(), n_tensors,
+                threshold, <double *> norms.data)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return norms
+
+    def cosine_similarity(self, np.ndarray A, np.ndarray B, *, double eps=1e-8):
+        """Cosine similarities of the rows of A against the rows of B, an
+        array of shape (len(A), len(B)). Norms are clamped to eps, like in
+        torch.nn.functional.cosine_similarity."""
+        cdef SleefArray array = self._array
+
+        if A.ndim != 2 or B.ndim != 2:
+            raise ValueError("cosine_similarity requires arrays of dimensionality 2")
+        if A.shape[1] != B.shape[1]:
+            raise ValueError("Rows of both arrays must have the same width")
+        if eps <= 0:
+            raise ValueError(f"eps must be positive, was {eps}")
+
+        cdef size_t n_a = A.shape[0]
+        cdef size_t n_b = B.shape[0]
+        cdef size_t d = A.shape[1]
+
+        A = self.as_contig(A)
+        B = np.ascontiguousarray(B, dtype=A.dtype)
+        cdef np.ndarray out = np.empty((n_a, n_b), dtype=A.dtype)
+
+        if A.dtype == np.float32:
+            array.cosine_similarity(<float *> out.data, <float *> A.data, <float *> B.data, n_a, n_b, d, eps)
+        elif A.dtype == np.float64:
+            array.cosine_similarity(<double *> out.data, <double *> A.data, <double *> B.data, n_a, n_b, d, eps)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return out
+
+    def dropout(self, np.ndarray X, double drop, *, uint64_t seed, uint64_t offset=0, inplace: bool=False):
+        """Apply dropout with probability drop to X, scaling the remaining
+        elements by 1 / (1 - drop). The mask is generated from the seed and
+        offset with a counter-based RNG, so it does not need to be stored:
+        dropout with the same seed and offset applied to the gradient is the
+        backward pass."""
+        cdef SleefArray array = self._array
+
+        if not 0 <= drop < 1:
+            raise ValueError(f"Dropout probability must be in [0, 1), was {drop}")
+
+        if inplace:
+            if not X.flags["C_CONTIGUOUS"]:
+                raise ValueError("Cannot apply operation in-place, array is not C-contiguous")
+        else:
+            X = X.copy()
+
+        cdef size_t n = X.size
+        if X.dtype == np.float32:
+            array.dropout(<float *> X.data, n, drop, seed, offset)
+        elif X.dtype == np.float64:
+            array.dropout(<double *> X.data, n, drop, seed, offset)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return X
+
     def erf(self, a: np.ndarray, *, inplace: bool=False):
         cdef SleefArray array = self._array
         cdef size_t n = a.size
@@ -52,6 +623,60 @@ class SleefOps(ops_superclass):
 
         return a
 
+    def flatten(self, X, dtype=None, pad=0, ndim_if_empty=2):
+        """Flatten a list of arrays into one large array, like thinc's
+        Ops.flatten, with a single copy. Lists that are not 2D float arrays
+        of the same dtype and width are handled by the superclass."""
+        cdef SleefArray array = self._array
+
+        ragged = _ragged_seqs(X)
+        if ragged is None or ragged[1].sum() == 0:
+            return super().flatten(X, dtype=dtype, pad=pad, ndim_if_empty=ndim_if_empty)
+        seqs, lengths = ragged
+
+        cdef size_t n_seqs = len(seqs)
+        cdef size_t nO = seqs[0].shape[1]
+        cdef size_t pad_ = max(int(pad), 0)
+        cdef size_t n = lengths.sum() + pad_ * (np.count_nonzero(lengths) + 1)
+        cdef vector[char *] seqs_ = _seqs_data(seqs)
+        cdef np.ndarray lengths_ = lengths
+        cdef np.ndarray out = np.empty((n, nO), dtype=seqs[0].dtype)
+
+        if out.dtype == np.float32:
+            array.flatten(<float *> out.data, <float **> seqs_.data(), <int *> lengths_.data, n_seqs, nO, pad_)
+        else:
+            array.flatten(<double *> out.data, <double **> seqs_.data(), <int *> lengths_.data, n_seqs, nO, pad_)
+
+        if dtype is not None:
+            out = np.asarray(out, dtype=dtype)
+        return out
+
+    def gather_add(self, np.ndarray table, indices):
+        """Sum the table rows given by each row of indices, like thinc's
+        Ops.gather_add. The table rows of upcoming rows are prefetched."""
+        cdef SleefArray array = self._array
+
+        if table.ndim != 2:
+            raise ValueError(f"gather_add requires table of dimensionality 2, was {table.ndim}")
+        cdef np.ndarray idx = _table_indices(indices, table.shape[0])
+        if idx.ndim != 2:
+            raise ValueError(f"gather_add requires indices of dimensionality 2, was {idx.ndim}")
+
+        cdef size_t n = idx.shape[0]
+        cdef size_t n_idx = idx.shape[1]
+        cdef size_t nO = table.shape[1]
+        table = self.as_contig(table)
+        cdef np.ndarray out = np.empty((n, nO), dtype=table.dtype)
+
+        if table.dtype == np.float32:
+            array.gather_add(<float *> out.data, <float *> table.data, <int *> idx.data, n, n_idx, nO)
+        elif table.dtype == np.float64:
+            array.gather_add(<double *> out.data, <double *> table.data, <int *> idx.data, n, n_idx, nO)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return out
+
     def gelu(self, np.ndarray a, *, inplace: bool=False):
         cdef SleefArray array = self._array
         cdef size_t n = a.size
@@ -94,7 +719,565 @@ class SleefOps(ops_superclass):
 
         return a
 
+    def get_dropout_mask(self, shape, drop):
+        """Create a dropout mask like thinc's Ops.get_dropout_mask, without
+        allocating an array of random numbers. The RNG is seeded from
+        NumPy's global RNG, so fix_random_seed makes the mask reproducible."""
+        cdef SleefArray array = self._array
+
+        if drop is None or drop <= 0:
+            return np.ones(shape, dtype="f")
+        elif drop >= 1.0:
+            return np.zeros(shape, dtype="f")
+
+        cdef uint64_t seed = _random_seed()
+        cdef np.ndarray mask = np.empty(shape, dtype="f")
+        cdef size_t n = mask.size
+        array.dropout_mask(<float *> mask.data, n, <double> drop, seed, 0)
+        return mask
+
+    def glorot_normal_init(self, shape, *, seed=None, dtype="float32"):
+        """Like thinc's glorot_normal_init, using this package's RNG."""
+        scale = np.sqrt(2.0 / (shape[0] + shape[1]))
+        return self.random_normal(np.empty(shape, dtype=dtype), 0.0, scale, seed=seed)
+
+    def glorot_uniform_init(self, shape, *, seed=None, dtype="float32"):
+        """Like thinc's glorot_uniform_init, using this package's RNG."""
+        scale = np.sqrt(6.0 / (shape[0] + shape[1]))
+        return self.random_uniform(np.empty(shape, dtype=dtype), -scale, scale, seed=seed)
+
+    def hash(self, ids, uint32_t seed):
+        """Hash a sequence of 64-bit keys into a table with 4 32-bit keys,
+        like thinc's NumpyOps.hash."""
+        cdef SleefArray array = self._array
+        cdef np.ndarray keys = np.ascontiguousarray(ids, dtype=np.uint64)
+        if keys.ndim != 1:
+            raise ValueError(f"hash requires array of dimensionality 1, was {keys.ndim}")
+
+        cdef np.ndarray out = np.empty((keys.shape[0], 4), dtype=np.uint32)
+        array.hash(<uint32_t *> out.data, <uint64_t *> keys.data, keys.shape[0], seed)
+        return out
+
+    def hash_embed(self, ids, np.ndarray table, uint32_t seed, *, save_keys: bool=False):
+        """HashEmbed lookup in a single call: hash the ids, take the four
+        hashes modulo the number of table rows and sum those rows. Returns
+        the embeddings and the table row of each hash (None unless
+        save_keys is set), which backprop_gather_add takes."""
+        cdef SleefArray array = self._array
+
+        if table.ndim != 2:
+            raise ValueError(f"hash_embed requires table of dimensionality 2, was {table.ndim}")
+        if table.shape[0] == 0 or table.shape[0] > np.iinfo(np.int32).max:
+            raise ValueError(f"Table with {table.shape[0]} rows is not supported")
+        cdef np.ndarray ids_ = np.ascontiguousarray(ids, dtype=np.uint64)
+        if ids_.ndim != 1:
+            raise ValueError(f"hash_embed requires ids of dimensionality 1, was {ids_.ndim}")
+
+        cdef size_t n = ids_.shape[0]
+        cdef size_t nV = table.shape[0]
+        cdef size_t nO = table.shape[1]
+        table = self.as_contig(table)
+        cdef np.ndarray out = np.empty((n, nO), dtype=table.dtype)
+        cdef np.ndarray keys = np.empty((n, 4), dtype=np.int32) if save_keys else None
+
+        if table.dtype == np.float32:
+            array.hash_embed(<float *> out.data, <int *> keys.data if keys is not None else NULL,
+                <float *> table.data, <uint64_t *> ids_.data, n, nV, nO, seed)
+        elif table.dtype == np.float64:
+            array.hash_embed(<double *> out.data, <int *> keys.data if keys is not None else NULL,
+                <double *> table.data, <uint64_t *> ids_.data, n, nV, nO, seed)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return out, keys
+
+    def l2_normalize(self, np.ndarray X, *, double eps=1e-12, inplace: bool=False):
+        """Divide each row of X along the last axis by its L2 norm, clamped
+        to eps like in torch.nn.functional.normalize."""
+        cdef SleefArray array = self._array
+
+        if X.ndim < 1:
+            raise ValueError("l2_normalize requires array of dimensionality of at least 1")
+        if eps <= 0:
+            raise ValueError(f"eps must be positive, was {eps}")
+
+        cdef size_t nO = X.shape[X.ndim - 1]
+        cdef size_t n = X.size // nO if nO != 0 else 0
+
+        if inplace:
+            if not X.flags["C_CONTIGUOUS"]:
+                raise ValueError("Cannot apply operation in-place, array is not C-contiguous")
+        else:
+            X = X.copy()
+
+        if X.dtype == np.float32:
+            array.l2_normalize(<float *> X.data, n, nO, eps)
+        elif X.dtype == np.float64:
+            array.l2_normalize(<double *> X.data, n, nO, eps)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return X
+
+    def list2padded(self, seqs):
+        """Pack a list of 2D arrays into a Padded datatype, like thinc's
+        Ops.list2padded, copying every row once."""
+        cdef SleefArray array = self._array
+
+        ragged = _ragged_seqs(seqs)
+        if ragged is None or len(seqs) < 2:
+            return super().list2padded(seqs)
+        seqs_list, lengths = ragged
+
+        # Sort by length, with ties in reverse order like Ops.list2padded.
+        indices = np.lexsort((np.arange(len(seqs_list)), lengths))[::-1].astype(np.int32)
+        lengths = np.ascontiguousarray(lengths[indices])
+        seqs_list = [seqs_list[i] for i in indices]
+
+        cdef size_t n_seqs = len(seqs_list)
+        cdef size_t n_pad = lengths[0]
+        cdef size_t nO = seqs_list[0].shape[1]
+        cdef vector[char *] seqs_ = _seqs_data(seqs_list)
+        cdef np.ndarray lengths_ = lengths
+        cdef np.ndarray out = np.empty((n_pad, n_seqs, nO), dtype=seqs_list[0].dtype)
+
+        if out.dtype == np.float32:
+            array.pad(<float *> out.data, <float **> seqs_.data(), <int *> lengths_.data, n_seqs, n_pad, nO, True)
+        else:
+            array.pad(<double *> out.data, <double **> seqs_.data(), <int *> lengths_.data, n_seqs, n_pad, nO, True)
+
+        size_at_t = n_seqs - np.cumsum(np.bincount(lengths, minlength=n_pad))[:n_pad]
+        return Padded(out, size_at_t.astype(np.int32), lengths, indices)
+
+    def lstm_gates(self, np.ndarray G, np.ndarray C_prev, *, inplace: bool=False):
+        """Compute one LSTM timestep from the pre-activation gates G, which
+        are interleaved per hidden unit as (forget, input, output, cell) like
+        in NumpyOps. Returns the hidden state, the cell state and the
+        activated gates, which backprop_lstm_gates needs. If inplace is set,
+        the activations overwrite G."""
+        cdef SleefArray array = self._array
+
+        if G.ndim != 2:
+            raise ValueError(f"lstm_gates requires gate array of dimensionality 2, was {G.ndim}")
+        if C_prev.ndim != 2:
+            raise ValueError(f"lstm_gates requires cell array of dimensionality 2, was {C_prev.ndim}")
+        if G.shape[0] != C_prev.shape[0] or G.shape[1] != C_prev.shape[1] * 4:
+            raise ValueError("Gate array must have four gates per hidden unit")
+
+        cdef size_t n = C_prev.size
+        if inplace:
+            if not G.flags["C_CONTIGUOUS"]:
+                raise ValueError("Cannot apply operation in-place, array is not C-contiguous")
+        else:
+            G = self.as_contig(G).copy()
+        C_prev = np.ascontiguousarray(C_prev, dtype=G.dtype)
+        cdef np.ndarray Y = np.empty_like(C_prev)
+        cdef np.ndarray C = np.empty_like(C_prev)
+
+        if G.dtype == np.float32:
+            array.lstm_gates(<float *> Y.data, <float *> C.data, <float *> G.data, <float *> C_prev.data, n)
+        elif G.dtype == np.float64:
+            array.lstm_gates(<double *> Y.data, <double *> C.data, <double *> G.data, <double *> C_prev.data, n)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return Y, C, G
+
+    def masked_softmax(self, np.ndarray X, lengths=None, *, double scale=1.0, inplace: bool=False):
+        """Softmax of scale * X over the last axis, restricted to the first
+        lengths entries of each row. The other entries are set to zero, so
+        padding needs no mask and no exp evaluations. lengths is broadcast
+        to X.shape[:-1], e.g. lengths[:, None, None] for attention scores of
+        shape (batch, heads, queries, keys)."""
+        cdef SleefArray array = self._array
+
+        if X.ndim == 0:
+            raise ValueError("masked_softmax requires array of dimensionality >= 1")
+        if scale <= 0:
+            raise ValueError(f"Scale must be positive, was {scale}")
+
+        if inplace:
+            if not X.flags["C_CONTIGUOUS"]:
+                raise ValueError("Cannot apply operation in-place, array is not C-contiguous")
+        else:
+            X = self.as_contig(X).copy()
+
+        cdef size_t nO = X.shape[X.ndim - 1]
+        cdef size_t n = X.size // nO if nO != 0 else 0
+        cdef np.ndarray lengths_ = None
+        if lengths is not None:
+            lengths_ = np.ascontiguousarray(np.broadcast_to(lengths, (<object> X).shape[:-1]), dtype=np.int32)
+
+        if X.dtype == np.float32:
+            array.masked_softmax(<float *> X.data, <int *> lengths_.data if lengths_ is not None else NULL,
+                n, nO, scale)
+        elif X.dtype == np.float64:
+            array.masked_softmax(<double *> X.data, <int *> lengths_.data if lengths_ is not None else NULL,
+                n, nO, scale)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return X
+
+    def maxout(self, np.ndarray X):
+        cdef SleefArray array = self._array
+
+        if X.ndim != 3:
+            raise ValueError(f"maxout requires array of dimensionality 3, was {X.ndim}")
+        if X.shape[2] == 0:
+            raise ValueError("maxout requires at least one piece")
+
+        cdef size_t n = X.shape[0] * X.shape[1]
+        cdef size_t P = X.shape[2]
+
+        X = self.as_contig(X)
+        cdef np.ndarray best = np.empty((X.shape[0], X.shape[1]), dtype=X.dtype)
+        cdef np.ndarray which = np.empty((X.shape[0], X.shape[1]), dtype=np.int32)
+
+        if X.dtype == np.float32:
+            array.maxout(<float *> best.data, <int *> which.data, <float *> X.data, n, P)
+        elif X.dtype == np.float64:
+            array.maxout(<double *> best.data, <int *> which.data, <double *> X.data, n, P)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return best, which
+
+    def maxout_layer_norm(self, np.ndarray X, G=None, b=None, *, double eps=1e-8):
+        """Maxout followed by layer normalization of each output row. Returns
+        the normalized output, the maxout piece indices and the per-row mean
+        and variance. Like in thinc's LayerNorm, eps is included in the
+        variance."""
+        cdef SleefArray array = self._array
+
+        if X.ndim != 3:
+            raise ValueError(f"maxout_layer_norm requires array of dimensionality 3, was {X.ndim}")
+        if X.shape[2] == 0:
+            raise ValueError("maxout_layer_norm requires at least one piece")
+
+        cdef size_t n = X.shape[0]
+        cdef size_t nO = X.shape[1]
+        cdef size_t nP = X.shape[2]
+
+        X = self.as_contig(X)
+        cdef np.ndarray G_ = np.ones(nO, dtype=X.dtype) if G is None else np.ascontiguousarray(G, dtype=X.dtype)
+        cdef np.ndarray b_ = np.zeros(nO, dtype=X.dtype) if b is None else np.ascontiguousarray(b, dtype=X.dtype)
+        if G_.size != nO or b_.size != nO:
+            raise ValueError(f"Scale and shift must have {nO} elements")
+
+        cdef np.ndarray Y = np.empty((n, nO), dtype=X.dtype)
+        cdef np.ndarray which = np.empty((n, nO), dtype=np.int32)
+        cdef np.ndarray mean = np.empty(n, dtype=X.dtype)
+        cdef np.ndarray var = np.empty(n, dtype=X.dtype)
+
+        if X.dtype == np.float32:
+            array.maxout_layer_norm(<float *> Y.data, <int *> which.data, <float *> mean.data, <float *> var.data,
+                <float *> X.data, <float *> G_.data, <float *> b_.data, n, nO, nP, eps)
+        elif X.dtype == np.float64:
+            array.maxout_layer_norm(<double *> Y.data, <int *> which.data, <double *> mean.data, <double *> var.data,
+                <double *> X.data, <double *> G_.data, <double *> b_.data, n, nO, nP, eps)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return Y, which, mean, var
+
+    def ngrams(self, int n, keys):
+        """Hash each window of n consecutive keys, like thinc's
+        NumpyOps.ngrams."""
+        cdef SleefArray array = self._array
+        if n < 1:
+            return np.zeros((0,), dtype=np.uint64)
+
+        cdef np.ndarray keys_ = np.ascontiguousarray(keys, dtype=np.uint64)
+        if keys_.ndim != 1:
+            raise ValueError(f"ngrams requires array of dimensionality 1, was {keys_.ndim}")
+
+        cdef size_t length = max(0, keys_.shape[0] - (n - 1))
+        cdef np.ndarray out = np.empty((length,), dtype=np.uint64)
+        array.ngrams(<uint64_t *> out.data, <uint64_t *> keys_.data, length, n)
+        return out
+
+    def normal_init(self, shape, *, double mean=0.0, std=None, seed=None, dtype="float32"):
+        """Samples weights of the given shape from a normal distribution,
+        using this package's RNG. The standard deviation defaults to
+        1 / sqrt(shape[1]), the input width of thinc's (nO, nI) weights."""
+        std_ = 1.0 / np.sqrt(shape[1]) if std is None else std
+        return self.random_normal(np.empty(shape, dtype=dtype), mean, std_, seed=seed)
+
+    def pack_weights(self, np.ndarray W):
+        """Pack the (nO, nI) weights W for use with affine. The packed
+        weights are a copy, so W must be packed again after it is updated."""
+        cdef SleefArray array = self._array
+
+        if W.ndim != 2:
+            raise ValueError(f"pack_weights requires array of dimensionality 2, was {W.ndim}")
+
+        cdef size_t nO = W.shape[0]
+        cdef size_t nI = W.shape[1]
+        cdef np.ndarray W_ = self.as_contig(W)
+        cdef np.ndarray packed_data
+
+        if W.dtype == np.float32:
+            packed_data = np.empty(array.affinef_packed_size(nO, nI), dtype=W.dtype)
+            array.affine_pack(<float *> packed_data.data, <float *> W_.data, nO, nI)
+        elif W.dtype == np.float64:
+            packed_data = np.empty(array.affine_packed_size(nO, nI), dtype=W.dtype)
+            array.affine_pack(<double *> packed_data.data, <double *> W_.data, nO, nI)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return PackedWeights(packed_data, nO, nI, array.instruction_set)
+
+    def pad(self, seqs, round_to=1):
+        """Pad a list of arrays to the same length, like thinc's Ops.pad,
+        copying every row once."""
+        cdef SleefArray array = self._array
+
+        ragged = _ragged_seqs(seqs)
+        if ragged is None or round_to < 1:
+            return super().pad(seqs, round_to=round_to)
+        seqs_list, lengths = ragged
+
+        cdef size_t n_seqs = len(seqs_list)
+        max_len = int(lengths.max())
+        cdef size_t n_pad = max_len + (-max_len % round_to)
+        cdef size_t nO = seqs_list[0].shape[1]
+        cdef vector[char *] seqs_ = _seqs_data(seqs_list)
+        cdef np.ndarray lengths_ = lengths
+        cdef np.ndarray out = np.empty((n_seqs, n_pad, nO), dtype=seqs_list[0].dtype)
+
+        if out.dtype == np.float32:
+            array.pad(<float *> out.data, <float **> seqs_.data(), <int *> lengths_.data, n_seqs, n_pad, nO, False)
+        else:
+            array.pad(<double *> out.data, <double **> seqs_.data(), <int *> lengths_.data, n_seqs, n_pad, nO, False)
+
+        return out
+
+    def padded2list(self, padded):
+        """Unpack a Padded datatype to a list of 2D arrays, like thinc's
+        Ops.padded2list. The arrays are views of a single output array."""
+        cdef SleefArray array = self._array
+
+        data = padded.data
+        if not isinstance(data, np.ndarray) or data.ndim != 3 \
+                or data.dtype not in (np.float32, np.float64):
+            return super().padded2list(padded)
+
+        cdef np.ndarray lengths = np.ascontiguousarray(padded.lengths, dtype=np.int32)
+        cdef size_t n_pad = data.shape[0]
+        cdef size_t n_seqs = data.shape[1]
+        cdef size_t nO = data.shape[2]
+        if lengths.shape[0] != n_seqs or (n_seqs and (lengths.min() < 0 or lengths.max() > n_pad)):
+            raise ValueError("Lengths do not match the padded data")
+        cdef np.ndarray data_ = self.as_contig(data)
+        cdef np.ndarray out = np.empty((lengths.sum(), nO), dtype=data.dtype)
+
+        starts = np.concatenate(([0], np.cumsum(lengths)))
+        seqs = [out[starts[i]:starts[i + 1]] for i in range(n_seqs)]
+        cdef vector[char *] seqs_ = _seqs_data(seqs)
+
+        if out.dtype == np.float32:
+            array.unpad(<float **> seqs_.data(), <float *> data_.data, <int *> lengths.data, n_seqs, n_pad, nO, True)
+        else:
+            array.unpad(<double **> seqs_.data(), <double *> data_.data, <int *> lengths.data, n_seqs, n_pad, nO, True)
+
+        unpadded = [None] * n_seqs
+        for i, index in enumerate(padded.indices):
+            unpadded[index] = seqs[i]
+        return unpadded
+
+    def position_encode(self, int N, int D, int period=10000, out=None):
+        """Sinusoidal position encoding, like thinc's Ops.position_encode.
+        The largest table computed so far is cached per (D, period), shorter
+        requests copy from it."""
+        cdef SleefArray array = self._array
+
+        if N < 0 or D < 0:
+            raise ValueError(f"Invalid position encoding shape: ({N}, {D})")
+
+        cdef np.ndarray table = self._position_encodings.get((D, period))
+        if table is None or table.shape[0] < N:
+            table = np.empty((N, D), dtype="f")
+            array.position_encode(<float *> table.data, N, D, period)
+            self._position_encodings[(D, period)] = table
+
+        if out is None:
+            return table[:N].copy()
+        if out.shape != (N, D):
+            raise ValueError(f"Output array must have shape ({N}, {D})")
+        out[...] = table[:N]
+        return out
+
+    def random_normal(self, np.ndarray out, double mean=0.0, double std=1.0, *, seed=None, uint64_t offset=0):
+        """Fill out in-place with samples from a normal distribution, using a
+        Box-Muller transform of a counter-based RNG. Samples only depend on
+        the seed and their position offset + i in the stream. If seed is
+        None, it is drawn from NumPy's global RNG."""
+        cdef SleefArray array = self._array
+
+        if not out.flags["C_CONTIGUOUS"]:
+            raise ValueError("Cannot apply operation in-place, array is not C-contiguous")
+        cdef uint64_t seed_ = _random_seed() if seed is None else seed
+
+        cdef size_t n = out.size
+        if out.dtype == np.float32:
+            array.random_normal(<float *> out.data, n, mean, std, seed_, offset)
+        elif out.dtype == np.float64:
+            array.random_normal(<double *> out.data, n, mean, std, seed_, offset)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return out
+
+    def random_uniform(self, np.ndarray out, double low=0.0, double high=1.0, *, seed=None, uint64_t offset=0):
+        """Fill out in-place with samples from a uniform distribution over
+        [low, high), see random_normal."""
+        cdef SleefArray array = self._array
+
+        if not out.flags["C_CONTIGUOUS"]:
+            raise ValueError("Cannot apply operation in-place, array is not C-contiguous")
+        cdef uint64_t seed_ = _random_seed() if seed is None else seed
+
+        cdef size_t n = out.size
+        if out.dtype == np.float32:
+            array.random_uniform(<float *> out.data, n, low, high, seed_, offset)
+        elif out.dtype == np.float64:
+            array.random_uniform(<double *> out.data, n, low, high, seed_, offset)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return out
+
+    def residual_layer_norm(self, np.ndarray X, np.ndarray R, G=None, b=None, *, double eps=1e-8, save_sum: bool=False):
+        """Layer normalization of X + R. Returns the normalized output, the
+        sum X + R (None unless save_sum is set) and the per-row mean and
+        variance. Like in thinc's LayerNorm, eps is included in the
+        variance."""
+        cdef SleefArray array = self._array
+
+        if X.ndim != 2:
+            raise ValueError(f"residual_layer_norm requires array of dimensionality 2, was {X.ndim}")
+        if R.ndim != 2 or X.shape[0] != R.shape[0] or X.shape[1] != R.shape[1]:
+            raise ValueError("Shape of the residual must match the shape of the input")
+
+        cdef size_t n = X.shape[0]
+        cdef size_t nO = X.shape[1]
+
+        X = self.as_contig(X)
+        R = self.as_contig(R, dtype=X.dtype)
+        cdef np.ndarray G_ = np.ones(nO, dtype=X.dtype) if G is None else np.ascontiguousarray(G, dtype=X.dtype)
+        cdef np.ndarray b_ = np.zeros(nO, dtype=X.dtype) if b is None else np.ascontiguousarray(b, dtype=X.dtype)
+        if G_.size != nO or b_.size != nO:
+            raise ValueError(f"Scale and shift must have {nO} elements")
+
+        cdef np.ndarray Y = np.empty((n, nO), dtype=X.dtype)
+        cdef np.ndarray S = np.empty((n, nO), dtype=X.dtype) if save_sum else None
+        cdef np.ndarray mean = np.empty(n, dtype=X.dtype)
+        cdef np.ndarray var = np.empty(n, dtype=X.dtype)
+
+        if X.dtype == np.float32:
+            array.residual_layer_norm(<float *> Y.data, <float *> S.data if S is not None else <float *> NULL,
+                <float *> mean.data, <float *> var.data, <float *> X.data, <float *> R.data,
+                <float *> G_.data, <float *> b_.data, n, nO, eps)
+        elif X.dtype == np.float64:
+            array.residual_layer_norm(<double *> Y.data, <double *> S.data if S is not None else <double *> NULL,
+                <double *> mean.data, <double *> var.data, <double *> X.data, <double *> R.data,
+                <double *> G_.data, <double *> b_.data, n, nO, eps)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return Y, S, mean, var
+
+    def sample(self, np.ndarray X, *, double temperature=1.0, double top_p=1.0, seed=None, uint64_t offset=0):
+        """Draw an index along the last axis of the logits X for each row,
+        from softmax(X / temperature) restricted to the most probable
+        entries with a total probability of top_p (nucleus sampling). Row i
+        uses random number offset + i of the seed's stream. A temperature of
+        0 selects the most probable entry."""
+        cdef SleefArray array = self._array
+
+        if X.ndim < 1 or X.shape[X.ndim - 1] == 0:
+            raise ValueError("sample requires a non-empty last axis")
+        if temperature < 0:
+            raise ValueError(f"Temperature must be non-negative, was {temperature}")
+        if not 0 < top_p <= 1:
+            raise ValueError(f"top_p must be in (0, 1], was {top_p}")
+        if temperature == 0:
+            return self.argmax(X)[1]
+        cdef uint64_t seed_ = _random_seed() if seed is None else seed
+
+        cdef size_t nO = X.shape[X.ndim - 1]
+        cdef size_t n = X.size // nO
+
+        X = self._to_contig_or_copy(X)
+        cdef np.ndarray which = np.empty((<object> X).shape[:-1], dtype=np.int32)
+
+        if X.dtype == np.float32:
+            array.sample(<int *> which.data, <float *> X.data, n, nO, temperature, top_p, seed_, offset)
+        elif X.dtype == np.float64:
+            array.sample(<int *> which.data, <double *> X.data, n, nO, temperature, top_p, seed_, offset)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return which
+
+    def scatter_add(self, table, indices, values):
+        """Add the rows of values to the table rows given by indices, like
+        NumpyOps.scatter_add. Repeated indices accumulate and negative indices
+        are skipped. Other layouts are handled by the superclass."""
+        cdef SleefArray array = self._array
+
+        if not isinstance(table, np.ndarray) or not isinstance(values, np.ndarray) \
+                or table.ndim != 2 or values.ndim != 2 or np.ndim(indices) != 1 \
+                or values.shape[0] != len(indices) or values.shape[1] != table.shape[1] \
+                or values.dtype != table.dtype or not table.flags["C_CONTIGUOUS"]:
+            return super().scatter_add(table, indices, values)
+
+        cdef np.ndarray table_ = table
+        cdef np.ndarray idx = _table_indices(indices, table_.shape[0], allow_negative=True)
+        cdef size_t n = idx.shape[0]
+        cdef size_t nO = table_.shape[1]
+        cdef np.ndarray values_ = self.as_contig(values)
+
+        if table_.dtype == np.float32:
+            array.scatter_add(<float *> table_.data, <int *> idx.data, <float *> values_.data, n, 1, nO)
+        elif table_.dtype == np.float64:
+            array.scatter_add(<double *> table_.data, <int *> idx.data, <double *> values_.data, n, 1, nO)
+        else:
+            return super().scatter_add(table, indices, values)
+
+        return table
+
+    def seq2col(self, np.ndarray seq, int nW, *, lengths=None):
+        cdef SleefArray array = self._array
+
+        if seq.ndim != 2:
+            raise ValueError(f"seq2col requires sequence array of dimensionality 2, was {seq.ndim}")
+        if nW < 0:
+            raise ValueError(f"Window size must be non-negative, was {nW}")
+
+        cdef size_t nF = 2 * nW + 1
+        cdef size_t nI = seq.shape[1]
+
+        cdef np.ndarray lengths_ = self._seq2col_lengths(lengths, seq.shape[0])
+        seq = self.as_contig(seq)
+        cdef np.ndarray cols = np.empty((seq.shape[0], nF * nI), dtype=seq.dtype)
+
+        if seq.dtype == np.float32:
+            array.seq2col(<float *> cols.data, <float *> seq.data, <int *> lengths_.data, lengths_.shape[0], nW, nI)
+        elif seq.dtype == np.float64:
+            array.seq2col(<double *> cols.data, <double *> seq.data, <int *> lengths_.data, lengths_.shape[0], nW, nI)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return cols
+
     def softmax(self, np.ndarray x, *, axis=-1, inplace=False):
+        if (axis == -1 or axis == x.ndim - 1) and x.ndim != 0 \
+                and (x.dtype == np.float32 or x.dtype == np.float64) \
+                and (not inplace or x.flags["C_CONTIGUOUS"]):
+            return self.masked_softmax(x, inplace=inplace)
+
         # Todo: vectorize max using SLEEF?
         maxes = self.xp.max(x, axis=axis, keepdims=True)
         if inplace:
@@ -148,6 +1331,102 @@ class SleefOps(ops_superclass):
 
         return a
 
+    def top_k(self, np.ndarray X, int k):
+        """The k largest values of each row of X along the last axis and
+        their indices, in descending order. Ties are ordered by index and NaN
+        counts as the largest value, like in argmax. The kernel is meant for
+        small k, larger k are selected with numpy."""
+        cdef SleefArray array = self._array
+
+        if X.ndim < 1:
+            raise ValueError("top_k requires array of dimensionality of at least 1")
+        if k < 1 or k > X.shape[X.ndim - 1]:
+            raise ValueError(f"k must be between 1 and the size of the last axis, was {k}")
+
+        cdef size_t nO = X.shape[X.ndim - 1]
+        cdef size_t n = X.size // nO
+
+        X = self.as_contig(X)
+        if k > _TOP_K_MAX:
+            # NaN first, then descending values, with ties in index order.
+            indices = np.lexsort((-X, ~np.isnan(X)), axis=-1)[..., :k].astype(np.int32)
+            return np.take_along_axis(X, indices, axis=-1), indices
+
+        shape = (<object> X).shape[:-1] + (k,)
+        cdef np.ndarray values = np.empty(shape, dtype=X.dtype)
+        cdef np.ndarray indices_ = np.empty(shape, dtype=np.int32)
+
+        if X.dtype == np.float32:
+            array.top_k(<float *> values.data, <int *> indices_.data, <float *> X.data, n, nO, k)
+        elif X.dtype == np.float64:
+            array.top_k(<double *> values.data, <int *> indices_.data, <double *> X.data, n, nO, k)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+        return values, indices_
+
+    def update_averages(self, np.ndarray ema, np.ndarray weights, int t, double max_decay=0.9999):
+        """Update the exponential moving average ema of weights in-place, with
+        the decay schedule of thinc's Ops.update_averages."""
+        cdef SleefArray array = self._array
+
+        _check_average_arrays(ema, weights)
+        cdef double decay = _average_decay(t, max_decay)
+
+        cdef size_t n = ema.size
+        if ema.dtype == np.float32:
+            array.update_averages(<float *> ema.data, <float *> weights.data, n, decay)
+        elif ema.dtype == np.float64:
+            array.update_averages(<double *> ema.data, <double *> weights.data, n, decay)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+    def update_averages_multi(self, emas, weights, int t, double max_decay=0.9999):
+        """Update the exponential moving averages emas of a list of weights
+        in-place, see update_averages."""
+        cdef SleefArray array = self._array
+
+        cdef size_t n_tensors = len(emas)
+        if len(weights) != n_tensors:
+            raise ValueError("Number of averages and weights must be equal")
+        if n_tensors == 0:
+            return
+        dtype = emas[0].dtype
+
+        cdef vector[char *] emas_, weights_
+        cdef vector[size_t] sizes
+        cdef np.ndarray ema, w
+        for ema, w in zip(emas, weights):
+            _check_average_arrays(ema, w)
+            if ema.dtype != dtype:
+                raise ValueError(f"Array of dtype {ema.dtype} does not match dtype {dtype}")
+            emas_.push_back(ema.data)
+            weights_.push_back(w.data)
+            sizes.push_back(ema.size)
+
+        cdef double decay = _average_decay(t, max_decay)
+
+        if dtype == np.float32:
+            array.update_averages_multi(<float **> emas_.data(), <float **> weights_.data(),
+                sizes.data(), n_tensors, decay)
+        elif dtype == np.float64:
+            array.update_averages_multi(<double **> emas_.data(), <double **> weights_.data(),
+                sizes.data(), n_tensors, decay)
+        else:
+            raise TypeError("Unhandled array dtype")
+
+    def _seq2col_lengths(self, lengths, size_t n):
+        if lengths is None:
+            return np.array([n], dtype=np.int32)
+
+        lengths = np.ascontiguousarray(lengths, dtype=np.int32)
+        if np.any(lengths < 0):
+            raise ValueError("All sequence lengths must be >= 0")
+        if lengths.sum() != n:
+            raise ValueError("The lengths must sum up to the batch length")
+
+        return lengths
+
     def _to_contig_or_copy(self, np.ndarray a, *, inplace: bool=False):
         is_contiguous = a.flags["C_CONTIGUOUS"] or a.flags["F_CONTIGUOUS"]
 
@@ -163,6 +1442,85 @@ class SleefOps(ops_superclass):
         return self.as_contig(a)
 
 
+cdef AdamParams _adam_params(double beta1, double beta2, double eps, double learn_rate,
+        double mod_rate, double grad_scale, double L2, double weight_decay):
+    cdef AdamParams params
+    params.beta1 = beta1
+    params.beta2 = beta2
+    params.eps = eps
+    params.learn_rate = learn_rate
+    params.mod_rate = mod_rate
+    params.grad_scale = grad_scale
+    params.L2 = L2
+    params.weight_decay = weight_decay
+    return params
+
+
+def _check_adam_arrays(np.ndarray weights, np.ndarray gradient, np.ndarray mom1, np.ndarray mom2, dtype):
+    for a in (gradient, mom1, mom2):
+        if a.size != weights.size:
+            raise ValueError(f"Array of size {a.size} does not match weights of size {weights.size}")
+    for a in (weights, gradient, mom1, mom2):
+        if a.dtype != dtype:
+            raise ValueError(f"Array of dtype {a.dtype} does not match dtype {dtype}")
+        if not a.flags["C_CONTIGUOUS"]:
+            raise ValueError("Cannot apply operation in-place, array is not C-contiguous")
+
+
+cdef double _average_decay(int t, double max_decay):
+    return min((1.0 + t) / (10.0 + t), max_decay)
+
+
+def _random_seed():
+    return int(np.random.randint(np.iinfo(np.int64).max, dtype=np.int64))
+
+
+def _table_indices(indices, size_t n_rows, allow_negative=False):
+    indices = np.asarray(indices)
+    if indices.size != 0:
+        if indices.max() >= n_rows or (not allow_negative and indices.min() < 0):
+            raise IndexError(f"Index out of bounds for table with {n_rows} rows")
+    return np.ascontiguousarray(indices, dtype=np.int32)
+
+
+def _ragged_seqs(seqs):
+    """Return seqs as C-contiguous arrays with their lengths if seqs is a
+    non-empty list of 2D float arrays with the same dtype and width,
+    otherwise None."""
+    if seqs is None or len(seqs) == 0:
+        return None
+    for seq in seqs:
+        if not isinstance(seq, np.ndarray) or seq.ndim != 2:
+            return None
+    dtype = seqs[0].dtype
+    width = seqs[0].shape[1]
+    if dtype != np.float32 and dtype != np.float64:
+        return None
+    for seq in seqs:
+        if seq.dtype != dtype or seq.shape[1] != width:
+            return None
+    seqs = [np.ascontiguousarray(seq) for seq in seqs]
+    lengths = np.array([seq.shape[0] for seq in seqs], dtype=np.int32)
+    return seqs, lengths
+
+
+cdef vector[char *] _seqs_data(seqs):
+    cdef vector[char *] data
+    cdef np.ndarray seq
+    for seq in seqs:
+        data.push_back(seq.data)
+    return data
+
+
+def _check_average_arrays(np.ndarray ema, np.ndarray weights):
+    if ema.size != weights.size:
+        raise ValueError(f"Average of size {ema.size} does not match weights of size {weights.size}")
+    if ema.dtype != weights.dtype:
+        raise ValueError(f"Average of dtype {ema.dtype} does not match weights of dtype {weights.dtype}")
+    if not ema.flags["C_CONTIGUOUS"] or not weights.flags["C_CONTIGUOUS"]:
+        raise ValueError("Cannot apply operation in-place, array is not C-contiguous")
+
+
 @contextmanager
 def with_cpu_feature(InstructionSet feature):
     ops = SleefOps()
@@ -3,6 +3,7 @@ import math
 import numpy as np
 import pytest
 
+from thinc.api import NumpyOps
 from thinc_sleef_ops import InstructionSet, SleefOps, with_cpu_feature
 
 M_SQRT1_2 = 1.0 / math.sqrt(2.0)
@@ -44,6 +45,9 @@ def test_inputs():
     ]
 
 
+numpy_ops = NumpyOps()
+
+
 @pytest.fixture
 def ops():
     return SleefOps()
@@ -66,12 +70,388 @@ def check_elementwise_function(
             assert np.allclose(inputs_copy, f_check(inputs), atol=1e-4)
 
 
+BIAS_ACTIVATIONS = {
+    "gelu": (
+        lambda x: x * numpy_cdf(x),
+        lambda x: numpy_cdf(x) + x * numpy_pdf(x),
+    ),
+    "identity": (lambda x: x, lambda x: np.ones_like(x)),
+    "relu": (lambda x: np.maximum(x, 0), lambda x: (x > 0).astype(x.dtype)),
+    "sigmoid": (
+        numpy_logistic_cdf,
+        lambda x: numpy_logistic_cdf(x) * (1 - numpy_logistic_cdf(x)),
+    ),
+    "swish": (
+        lambda x: x * numpy_logistic_cdf(x),
+        lambda x: numpy_logistic_cdf(x) + x * numpy_logistic_pdf(x),
+    ),
+    "tanh": (np.tanh, lambda x: 1 - np.tanh(x) ** 2),
+}
+
+
+def numpy_adam(weights, gradient, mom1, mom2, beta1, beta2, eps, learn_rate):
+    mom1 = beta1 * mom1 + (1 - beta1) * gradient
+    mom2 = beta2 * mom2 + (1 - beta2) * gradient**2
+    weights = weights - learn_rate * mom1 / (np.sqrt(mom2) + eps)
+    return weights, gradient, mom1, mom2
+
+
 @pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
 @pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("n", [1, 7, 67])
+def test_adam(cpu_feature, dtype, n):
+    weights = np.random.normal(size=n).astype(dtype)
+    gradient = np.random.normal(size=n).astype(dtype)
+    mom1 = np.random.normal(size=n).astype(dtype)
+    mom2 = np.random.uniform(size=n).astype(dtype)
+    args = (0.9, 0.999, 1e-8, 0.01)
+    expected = numpy_adam(weights, gradient, mom1, mom2, *args)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        result = feature_ops.adam(weights, gradient, mom1, mom2, *args)
+        assert result[0] is weights
+        for a, b in zip(result, expected):
+            assert np.allclose(a, b, atol=1e-6)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+def test_adam_regularization(cpu_feature, dtype):
+    weights = np.random.normal(size=(3, 11)).astype(dtype)
+    gradient = np.random.normal(size=(3, 11)).astype(dtype)
+    mom1 = np.zeros_like(weights)
+    mom2 = np.zeros_like(weights)
+    L2, grad_scale, weight_decay = 1e-2, 0.5, 1e-3
+    expected_gradient = (gradient + L2 * weights) * grad_scale
+    expected = numpy_adam(weights, expected_gradient, mom1, mom2, 0.9, 0.999, 1e-8, 0.01)
+    expected_weights = expected[0] * (1 - weight_decay)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        result = feature_ops.adam(
+            weights,
+            gradient,
+            mom1,
+            mom2,
+            0.9,
+            0.999,
+            1e-8,
+            0.01,
+            grad_scale=grad_scale,
+            L2=L2,
+            weight_decay=weight_decay,
+        )
+        assert np.allclose(result[0], expected_weights, atol=1e-6)
+        assert np.allclose(result[2], expected[2], atol=1e-6)
+        assert np.allclose(result[3], expected[3], atol=1e-6)
+
+        with pytest.raises(ValueError):
+            feature_ops.adam(weights, gradient[:, :5], mom1, mom2, 0.9, 0.999, 1e-8, 0.01)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("grad_clip", [0.0, 1.0, 100.0])
+def test_adam_multi(cpu_feature, dtype, grad_clip):
+    sizes = [1, 17, 64, 5]
+    weights = [np.random.normal(size=n).astype(dtype) for n in sizes]
+    gradients = [np.random.normal(size=n).astype(dtype) for n in sizes]
+    mom1 = [np.random.normal(size=n).astype(dtype) for n in sizes]
+    mom2 = [np.random.uniform(size=n).astype(dtype) for n in sizes]
+    args = (0.9, 0.999, 1e-8, 0.01)
+
+    norm = np.sqrt(sum((g.astype(np.float64) ** 2).sum() for g in gradients))
+    scale = grad_clip / norm if 0 < grad_clip <= norm else 1.0
+    expected = [
+        numpy_adam(w, g * scale, m1, m2, *args)
+        for w, g, m1, m2 in zip(weights, gradients, mom1, mom2)
+    ]
+
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        result_norm = feature_ops.adam_multi(
+            weights, gradients, mom1, mom2, *args, grad_clip=grad_clip
+        )
+        assert np.isclose(result_norm, norm)
+        for i, (w, _, m1, m2) in enumerate(expected):
+            assert np.allclose(weights[i], w, atol=1e-6)
+            assert np.allclose(mom1[i], m1, atol=1e-6)
+            assert np.allclose(mom2[i], m2, atol=1e-6)
+
+        assert feature_ops.adam_multi([], [], [], [], *args) == 0.0
+        with pytest.raises(ValueError):
+            feature_ops.adam_multi(weights, gradients[:-1], mom1, mom2, *args)
+        with pytest.raises(ValueError):
+            feature_ops.adam_multi(
+                weights, [g.astype(np.float16) for g in gradients], mom1, mom2, *args
+            )
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+def test_adam_rows(cpu_feature, dtype):
+    n, nO = 6, 19
+    args = (0.9, 0.999, 1e-8, 0.01)
+    weights = np.random.normal(size=(n, nO)).astype(dtype)
+    mom1 = np.zeros_like(weights)
+    mom2 = np.zeros_like(weights)
+    last_step = np.zeros(n, dtype=np.int32)
+    expected = [weights.copy(), mom1.copy(), mom2.copy()]
+    expected_last_step = np.zeros(n)
+
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        for step, rows in [(1, [0, 2]), (2, [3]), (4, [2, 0, 5])]:
+            gradient = np.random.normal(size=(len(rows), nO)).astype(dtype)
+            for row, g in zip(rows, gradient):
+                skipped = step - expected_last_step[row] - 1
+                m1 = expected[1][row] * args[0] ** skipped
+                m2 = expected[2][row] * args[1] ** skipped
+                w, _, m1, m2 = numpy_adam(expected[0][row], g, m1, m2, *args)
+                expected[0][row], expected[1][row], expected[2][row] = w, m1, m2
+                expected_last_step[row] = step
+
+            feature_ops.adam_rows(
+                weights, gradient, mom1, mom2, rows, last_step, step, *args
+            )
+            assert np.array_equal(last_step, expected_last_step)
+            for a, b in zip((weights, mom1, mom2), expected):
+                assert np.allclose(a, b, atol=1e-6)
+
+        with pytest.raises(ValueError):
+            feature_ops.adam_rows(
+                weights, gradient[:2], mom1, mom2, [1, 1], last_step, 5, *args
+            )
+        with pytest.raises(ValueError):
+            feature_ops.adam_rows(
+                weights, gradient[:1], mom1, mom2, [n], last_step, 5, *args
+            )
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("activation", list(BIAS_ACTIVATIONS))
+@pytest.mark.parametrize("shape", [(1, 1, 1), (9, 21, 13), (70, 37, 64)])
+def test_affine(cpu_feature, dtype, activation, shape):
+    n, nO, nI = shape
+    X = np.random.normal(size=(n, nI)).astype(dtype)
+    W = np.random.normal(size=(nO, nI)).astype(dtype) / np.sqrt(nI)
+    b = np.random.normal(size=nO).astype(dtype)
+    f, _ = BIAS_ACTIVATIONS[activation]
+    expected = f(X.astype(np.float64) @ W.T.astype(np.float64) + b)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        Y = feature_ops.affine(X, W, b, activation=activation)
+        assert Y.dtype == dtype
+        assert Y.shape == (n, nO)
+        assert np.allclose(Y, expected, atol=1e-4)
+
+        packed = feature_ops.pack_weights(W)
+        assert np.allclose(feature_ops.affine(X, packed, b, activation=activation), Y)
+        assert np.allclose(feature_ops.affine(X, W, b, activation=activation), Y)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+def test_affine_packed_weights(cpu_feature):
+    X = np.random.normal(size=(5, 8)).astype(np.float32)
+    W = np.random.normal(size=(3, 8)).astype(np.float32)
+    b = np.zeros(3, dtype=np.float32)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        packed = feature_ops.pack_weights(W)
+        assert np.allclose(feature_ops.affine(X, packed, b), X @ W.T, atol=1e-4)
+        # Arrays are packed on every call, so in-place updates are seen.
+        W += 1
+        assert np.allclose(feature_ops.affine(X, W, b), X @ W.T, atol=1e-4)
+
+        with pytest.raises(ValueError):
+            feature_ops.affine(X.astype(np.float64), packed, b)
+        for other in SleefOps.instruction_sets():
+            with with_cpu_feature(other) as other_ops:
+                if other == cpu_feature:
+                    assert np.allclose(other_ops.affine(X, packed, b), X @ (W - 1).T, atol=1e-4)
+                else:
+                    with pytest.raises(ValueError):
+                        other_ops.affine(X, packed, b)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("shape", [(1,), (7, 13), (3, 5, 37)])
+def test_argmax(cpu_feature, dtype, shape):
+    X = np.random.normal(size=shape).astype(dtype)
+    # Ties must resolve to the first index.
+    X.reshape(-1, shape[-1])[0, shape[-1] // 2 :] = 5.0
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        best, which = feature_ops.argmax(X)
+        assert best.dtype == dtype
+        assert np.array_equal(best, X.max(axis=-1))
+        assert np.array_equal(which, X.argmax(axis=-1))
+
+        # NaN is the maximum, also when it follows a larger value.
+        rows = X.reshape(-1, shape[-1]).copy()
+        rows[0, -1] = np.nan
+        rows[-1, :] = np.inf
+        rows[-1, -1] = np.nan
+        best, which = feature_ops.argmax(rows)
+        assert np.array_equal(best, rows.max(axis=-1), equal_nan=True)
+        assert np.array_equal(which, rows.argmax(axis=-1))
+
+
+def numpy_attention(Q, K, V, scale):
+    scores = scale * Q @ np.swapaxes(K, -1, -2)
+    return numpy_softmax(scores) @ V
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("shape", [(1, 5, 7, 8, 8), (2, 37, 150, 13, 5), (3, 20, 64, 16, 16)])
+def test_attention(cpu_feature, dtype, shape):
+    B, n_q, n_k, d, d_v = shape
+    # Large scores check that the running maximum is maintained correctly.
+    Q = (np.random.normal(size=(B, n_q, d)) * 3).astype(dtype)
+    K = np.random.normal(size=(B, n_k, d)).astype(dtype)
+    V = np.random.normal(size=(B, n_k, d_v)).astype(dtype)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        out = feature_ops.attention(Q, K, V)
+        assert out.dtype == dtype
+        assert np.allclose(out, numpy_attention(Q, K, V, 1 / np.sqrt(d)), atol=1e-4)
+
+        lengths = np.arange(B) * (n_k // 2)
+        out = feature_ops.attention(Q, K, V, lengths=lengths, scale=0.5)
+        for b, length in enumerate(lengths):
+            if length == 0:
+                assert np.all(out[b] == 0)
+            else:
+                expected = numpy_attention(Q[b], K[b, :length], V[b, :length], 0.5)
+                assert np.allclose(out[b], expected, atol=1e-4)
+
+        with pytest.raises(ValueError):
+            feature_ops.attention(Q[..., :0], K[..., :0], V)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("activation", list(BIAS_ACTIVATIONS))
 @pytest.mark.parametrize("inplace", [True, False])
-@pytest.mark.parametrize("X", test_inputs())
-def test_exp(ops, cpu_feature, dtype, inplace, X):
-    check_elementwise_function("exp", np.exp, cpu_feature, dtype, inplace, X)
+@pytest.mark.parametrize("shape", [(9, 21), (2, 64)])
+def test_bias_act(cpu_feature, dtype, activation, inplace, shape):
+    Y = np.random.normal(size=shape).astype(dtype) * 3
+    b = np.random.normal(size=shape[1]).astype(dtype)
+    f, f_backward = BIAS_ACTIVATIONS[activation]
+    X = Y + b
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        Y_copy = Y.copy()
+        out, D = feature_ops.bias_act(
+            Y_copy, b, activation, inplace=inplace, save_derivative=True
+        )
+        assert out.dtype == dtype
+        assert np.allclose(out, f(X), atol=1e-4)
+        assert np.allclose(D, f_backward(X), atol=1e-4)
+        if inplace:
+            assert out is Y_copy
+        assert feature_ops.bias_act(Y, b, activation)[1] is None
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("inplace", [True, False])
+@pytest.mark.parametrize("shape", [(9, 21), (2, 64)])
+def test_backprop_bias_act(cpu_feature, dtype, inplace, shape):
+    dY = np.random.normal(size=shape).astype(dtype)
+    D = np.random.normal(size=shape).astype(dtype)
+    expected_dX = dY * D
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        dY_copy = dY.copy()
+        dX, db = feature_ops.backprop_bias_act(dY_copy, D, inplace=inplace)
+        assert dX.dtype == dtype
+        assert np.allclose(dX, expected_dX)
+        assert np.allclose(db, expected_dX.sum(axis=0), atol=1e-5)
+        if inplace:
+            assert dX is dY_copy
+
+        db_acc = np.ones(shape[1], dtype=dtype)
+        _, db = feature_ops.backprop_bias_act(dY, D, db=db_acc)
+        assert db is db_acc
+        assert np.allclose(db, 1 + expected_dX.sum(axis=0), atol=1e-5)
+        with pytest.raises(ValueError):
+            feature_ops.backprop_bias_act(dY, D[:, 0])
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("n", [1, 7, 100])
+@pytest.mark.parametrize("threshold", [0.5, 1000.0])
+def test_clip_gradient(cpu_feature, dtype, n, threshold):
+    gradient = np.random.normal(size=n).astype(dtype)
+    expected = numpy_ops.clip_gradient(gradient.copy(), threshold)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        result = feature_ops.clip_gradient(gradient, threshold)
+        assert result is gradient
+        assert np.allclose(result, expected)
+
+        # Other dtypes and layouts are handled by thinc.
+        half = np.random.normal(size=n).astype(np.float16)
+        expected = numpy_ops.clip_gradient(half.copy(), threshold)
+        assert np.allclose(feature_ops.clip_gradient(half, threshold), expected, atol=1e-3)
+        strided = np.random.normal(size=2 * n).astype(dtype)[::2]
+        expected = numpy_ops.clip_gradient(strided.copy(), threshold)
+        result = feature_ops.clip_gradient(strided, threshold)
+        assert result is strided
+        assert np.allclose(result, expected)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+def test_clip_gradient_multi(cpu_feature, dtype):
+    gradients = [np.random.normal(size=n).astype(dtype) for n in [1, 15, 300]]
+    expected_norms = [np.linalg.norm(g) for g in gradients]
+    expected = [numpy_ops.clip_gradient(g.copy(), 2.0) for g in gradients]
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        norms = feature_ops.clip_gradient_multi(gradients, 2.0)
+        assert np.allclose(norms, expected_norms)
+        for g, e in zip(gradients, expected):
+            assert np.allclose(g, e)
+
+        assert feature_ops.clip_gradient_multi([], 2.0).shape == (0,)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("shape", [(1, 1, 1), (9, 21, 13), (70, 37, 64)])
+def test_cosine_similarity(cpu_feature, dtype, shape):
+    n_a, n_b, d = shape
+    A = np.random.normal(size=(n_a, d)).astype(dtype)
+    B = np.random.normal(size=(n_b, d)).astype(dtype)
+    B[0] = 0.0
+    norms_a = np.maximum(np.linalg.norm(A, axis=1), 1e-8)
+    norms_b = np.maximum(np.linalg.norm(B, axis=1), 1e-8)
+    check = A @ B.T / norms_a[:, None] / norms_b
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        out = feature_ops.cosine_similarity(A, B)
+        assert out.dtype == dtype
+        assert np.allclose(out, check, rtol=1e-5, atol=1e-6)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("drop", [0.0, 0.25, 0.9])
+def test_dropout(ops, cpu_feature, dtype, drop):
+    X = np.random.uniform(1.0, 2.0, size=(50, 47)).astype(dtype)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        Y = feature_ops.dropout(X, drop, seed=42)
+        kept = Y != 0
+        assert np.allclose(Y[kept], X[kept] / (1 - drop))
+        assert abs(1 - kept.mean() - drop) < 0.05
+
+        # The mask only depends on the seed and offset.
+        assert np.array_equal(feature_ops.dropout(np.ones_like(X), drop, seed=42) != 0, kept)
+        assert np.array_equal(ops.dropout(X, drop, seed=42), Y)
+        tail = feature_ops.dropout(X.ravel()[5:], drop, seed=42, offset=5)
+        assert np.array_equal(tail, Y.ravel()[5:])
+        if drop > 0:
+            assert not np.array_equal(feature_ops.dropout(X, drop, seed=43), Y)
+
+        X_copy = X.copy()
+        assert feature_ops.dropout(X_copy, drop, seed=42, inplace=True) is X_copy
+        assert np.array_equal(X_copy, Y)
+
+        for invalid in [-0.5, 1.0, float("nan")]:
+            with pytest.raises(ValueError):
+                feature_ops.dropout(X, invalid, seed=42)
 
 
 @pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
@@ -103,6 +483,64 @@ def test_erff_torch(ops, cpu_feature, dtype, inplace):
     )
 
 
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("inplace", [True, False])
+@pytest.mark.parametrize("X", test_inputs())
+def test_exp(ops, cpu_feature, dtype, inplace, X):
+    check_elementwise_function("exp", np.exp, cpu_feature, dtype, inplace, X)
+
+
+def ragged_seqs(lengths, nO, dtype):
+    return [np.random.normal(size=(length, nO)).astype(dtype) for length in lengths]
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("pad", [0, 2])
+@pytest.mark.parametrize("lengths", [[3], [4, 0, 1, 7], [0, 0]])
+def test_flatten(cpu_feature, dtype, pad, lengths):
+    seqs = ragged_seqs(lengths, 5, dtype)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        flat = feature_ops.flatten(seqs, pad=pad)
+        check = numpy_ops.flatten(seqs, pad=pad)
+        assert flat.dtype == check.dtype
+        assert np.array_equal(flat, check)
+        unflat = feature_ops.unflatten(flat, np.array(lengths), pad=pad)
+        for seq, check in zip(unflat, seqs):
+            assert np.array_equal(seq, check)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("shape", [(0, 4, 9), (13, 4, 9), (7, 1, 64), (3, 2, 37)])
+def test_gather_add(cpu_feature, dtype, shape):
+    n, n_idx, nO = shape
+    table = np.random.normal(size=(50, nO)).astype(dtype)
+    indices = np.random.randint(0, 50, size=(n, n_idx))
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        out = feature_ops.gather_add(table, indices)
+        assert out.dtype == dtype
+        assert np.allclose(out, table[indices].sum(axis=1), atol=1e-5)
+
+        with pytest.raises(IndexError):
+            feature_ops.gather_add(table, np.full((1, n_idx), 50))
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+def test_backprop_gather_add(cpu_feature, dtype):
+    indices = np.random.randint(0, 8, size=(23, 4))
+    dY = np.random.normal(size=(23, 17)).astype(dtype)
+    expected = np.zeros((8, 17), dtype=dtype)
+    for k in range(indices.shape[1]):
+        np.add.at(expected, indices[:, k], dY)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        dE = feature_ops.backprop_gather_add(dY, indices, 8)
+        assert dE.dtype == dtype
+        assert np.allclose(dE, expected, atol=1e-5)
+
+
 @pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
 @pytest.mark.parametrize("dtype", [np.float32, np.float64])
 @pytest.mark.parametrize("inplace", [True, False])
@@ -158,6 +596,429 @@ def test_gelu_backward_torch(ops, cpu_feature, dtype, inplace):
     )
 
 
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("drop", [None, 0.0, 0.5, 1.0])
+def test_get_dropout_mask(cpu_feature, drop):
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        mask = feature_ops.get_dropout_mask((30, 40), drop)
+        assert mask.shape == (30, 40)
+        assert mask.dtype == np.float32
+        if drop is None or drop == 0:
+            assert np.all(mask == 1)
+        elif drop == 1:
+            assert np.all(mask == 0)
+        else:
+            assert set(np.unique(mask)) == {0, 1 / (1 - drop)}
+            assert abs((mask == 0).mean() - drop) < 0.05
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+def test_glorot_init(ops, cpu_feature):
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        W = feature_ops.glorot_uniform_init((200, 300))
+        assert W.dtype == np.float32
+        scale = np.sqrt(6.0 / 500)
+        assert W.min() >= -scale and W.max() < scale
+        W = feature_ops.glorot_normal_init((200, 300), dtype="float64")
+        assert W.dtype == np.float64
+        assert abs(W.std() - np.sqrt(2.0 / 500)) < 0.005
+        W = feature_ops.normal_init((200, 400), mean=1.0)
+        assert W.dtype == np.float32
+        assert abs(W.mean() - 1.0) < 0.005
+        assert abs(W.std() - 0.05) < 0.005
+        expected = ops.random_normal(np.empty((3, 4), dtype="f"), 0.0, 2.0, seed=1)
+        assert np.array_equal(feature_ops.normal_init((3, 4), std=2.0, seed=1), expected)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("n", [0, 1, 7, 67])
+def test_hash(cpu_feature, n):
+    ids = np.random.randint(0, 2**63, size=n, dtype=np.uint64)
+    ids[:1] = 2**64 - 1
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        for seed in (0, 1, 2**32 - 1):
+            keys = feature_ops.hash(ids, seed)
+            assert keys.dtype == np.uint32
+            assert np.array_equal(keys, numpy_ops.hash(ids, seed))
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("n", [0, 5, 150])
+def test_hash_embed(cpu_feature, dtype, n):
+    ids = np.random.randint(0, 2**63, size=n, dtype=np.uint64)
+    table = np.random.normal(size=(97, 19)).astype(dtype)
+    keys_check = numpy_ops.hash(ids, 7) % table.shape[0]
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        out, keys = feature_ops.hash_embed(ids, table, 7)
+        assert keys is None
+        assert out.dtype == dtype
+        assert np.allclose(out, table[keys_check].sum(axis=1), atol=1e-5)
+
+        _, keys = feature_ops.hash_embed(ids, table, 7, save_keys=True)
+        assert np.array_equal(keys, keys_check)
+
+
+def blocked_gates(G):
+    # thinc's backprop_lstm_gates expects the gates as four blocks.
+    N, nO4 = G.shape
+    return G.reshape((N, nO4 // 4, 4)).transpose((0, 2, 1)).reshape((N, nO4))
+
+
+def interleaved_gates(G):
+    N, nO4 = G.shape
+    return G.reshape((N, 4, nO4 // 4)).transpose((0, 2, 1)).reshape((N, nO4))
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("inplace", [True, False])
+@pytest.mark.parametrize("shape", [(3,), (9, 21), (70, 2, 37)])
+def test_l2_normalize(cpu_feature, dtype, inplace, shape):
+    X = np.random.normal(size=shape).astype(dtype)
+    X.reshape(-1, shape[-1])[0] = 0.0
+    check = X / np.maximum(np.linalg.norm(X, axis=-1, keepdims=True), 1e-12)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        Y = feature_ops.l2_normalize(X, inplace=inplace)
+        assert (Y is X) == inplace
+        assert np.allclose(Y, check, rtol=1e-6, atol=1e-7)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("lengths", [[3], [4, 2, 1, 7, 2], [5, 0, 5]])
+def test_list2padded(cpu_feature, dtype, lengths):
+    seqs = ragged_seqs(lengths, 3, dtype)
+    check = numpy_ops.list2padded(seqs)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        padded = feature_ops.list2padded(seqs)
+        assert padded.data.dtype == dtype
+        assert np.array_equal(padded.data, check.data)
+        assert np.array_equal(padded.size_at_t, check.size_at_t)
+        assert np.array_equal(padded.lengths, check.lengths)
+        assert np.array_equal(padded.indices, check.indices)
+
+        for seq, check_seq in zip(feature_ops.padded2list(padded), seqs):
+            assert np.array_equal(seq, check_seq)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("inplace", [False, True])
+@pytest.mark.parametrize("shape", [(3, 5), (2, 16), (1, 37)])
+def test_lstm_gates(cpu_feature, dtype, inplace, shape):
+    G = np.random.normal(size=(shape[0], shape[1] * 4)).astype(dtype)
+    C_prev = np.random.normal(size=shape).astype(dtype)
+    G3 = G.reshape((shape[0], shape[1], 4))
+    hf = numpy_logistic_cdf(G3[:, :, 0])
+    hi = numpy_logistic_cdf(G3[:, :, 1])
+    ho = numpy_logistic_cdf(G3[:, :, 2])
+    hc = np.tanh(G3[:, :, 3])
+    C_check = hf * C_prev + hi * hc
+    Y_check = np.tanh(C_check) * ho
+    G_check = np.stack((hf, hi, ho, hc), axis=-1).reshape(G.shape)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        G_copy = G.copy()
+        Y, C, G_act = feature_ops.lstm_gates(G_copy, C_prev, inplace=inplace)
+        assert Y.dtype == dtype
+        assert np.allclose(Y, Y_check, atol=1e-6)
+        assert np.allclose(C, C_check, atol=1e-6)
+        assert np.allclose(G_act, G_check, atol=1e-6)
+        assert (G_act is G_copy) == inplace
+
+        with pytest.raises(ValueError):
+            feature_ops.lstm_gates(G.ravel(), C_prev)
+        with pytest.raises(ValueError):
+            feature_ops.lstm_gates(G, C_prev.ravel())
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("shape", [(3, 5), (2, 16), (1, 37)])
+def test_backprop_lstm_gates(cpu_feature, dtype, shape):
+    from thinc.backends.ops import backprop_lstm_gates
+
+    G = np.random.normal(size=(shape[0], shape[1] * 4)).astype(dtype)
+    C_prev = np.random.normal(size=shape).astype(dtype)
+    dY = np.random.normal(size=shape).astype(dtype)
+    dC = np.random.normal(size=shape).astype(dtype)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        _, C, G_act = feature_ops.lstm_gates(G, C_prev)
+        dG, dC_prev = feature_ops.backprop_lstm_gates(dY, dC, G_act, C, C_prev)
+        dG_check, dC_prev_check = backprop_lstm_gates(
+            dY, dC.copy(), blocked_gates(G_act), C, C_prev
+        )
+        assert dG.dtype == dtype
+        assert np.allclose(dG, interleaved_gates(dG_check), atol=1e-5)
+        assert np.allclose(dC_prev, dC_prev_check, atol=1e-5)
+
+        args = (dY, dC, G_act, C, C_prev)
+        for i in range(len(args)):
+            with pytest.raises(ValueError):
+                feature_ops.backprop_lstm_gates(*args[:i], args[i].ravel(), *args[i + 1 :])
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("inplace", [False, True])
+@pytest.mark.parametrize("nO", [1, 8, 37])
+def test_masked_softmax(cpu_feature, dtype, inplace, nO):
+    X = np.random.normal(size=(3, 4, nO)).astype(dtype)
+    lengths = np.array([nO, 0, max(nO - 5, 1)])
+    expected = np.zeros_like(X)
+    for i, length in enumerate(lengths):
+        if length:
+            expected[i, :, :length] = numpy_softmax(0.5 * X[i, :, :length])
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        X_copy = X.copy()
+        Y = feature_ops.masked_softmax(X_copy, lengths[:, None], scale=0.5, inplace=inplace)
+        assert Y.dtype == dtype
+        assert np.allclose(Y, expected, atol=1e-6)
+        assert (Y is X_copy) == inplace
+
+        assert np.allclose(feature_ops.masked_softmax(X), numpy_softmax(X), atol=1e-6)
+        with pytest.raises(ValueError):
+            feature_ops.masked_softmax(X, lengths[:, None], scale=0.0)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("shape", [(7, 13, 3), (5, 9, 1), (2, 35, 4)])
+def test_maxout(cpu_feature, dtype, shape):
+    X = np.random.normal(size=shape).astype(dtype)
+    # Ties must resolve to the first piece.
+    X[0, 0, :] = 1.0
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        best, which = feature_ops.maxout(X)
+        best_check, which_check = numpy_ops.maxout(X)
+        assert best.dtype == dtype
+        assert np.array_equal(best, best_check)
+        assert np.array_equal(which, which_check)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("shape", [(7, 13, 3), (5, 9, 1), (2, 35, 4)])
+def test_maxout_layer_norm(cpu_feature, dtype, shape):
+    X = np.random.normal(size=shape).astype(dtype)
+    G = np.random.normal(size=shape[1]).astype(dtype)
+    b = np.random.normal(size=shape[1]).astype(dtype)
+    best, which_check = numpy_ops.maxout(X)
+    mean_check = best.mean(axis=1)
+    var_check = best.var(axis=1) + 1e-8
+    Y_check = (best - mean_check[:, None]) / np.sqrt(var_check[:, None]) * G + b
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        Y, which, mean, var = feature_ops.maxout_layer_norm(X, G, b)
+        assert Y.dtype == dtype
+        assert np.array_equal(which, which_check)
+        assert np.allclose(mean, mean_check, atol=1e-5)
+        assert np.allclose(var, var_check, atol=1e-5)
+        assert np.allclose(Y, Y_check, atol=1e-4)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("shape", [(7, 13, 3), (5, 9, 1), (2, 35, 4)])
+def test_backprop_maxout(cpu_feature, dtype, shape):
+    B, O, P = shape
+    dY = np.random.normal(size=(B, O)).astype(dtype)
+    which = np.random.randint(0, P, size=(B, O), dtype=np.int32)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        dX = feature_ops.backprop_maxout(dY, which, P)
+        assert dX.dtype == dtype
+        assert np.array_equal(dX, numpy_ops.backprop_maxout(dY, which, P))
+        with pytest.raises(ValueError):
+            feature_ops.backprop_maxout(dY, which[:, 0], P)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("n", [1, 2, 3, 10])
+def test_ngrams(cpu_feature, n):
+    keys = np.random.randint(0, 2**63, size=37, dtype=np.uint64)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        assert np.array_equal(feature_ops.ngrams(n, keys), numpy_ops.ngrams(n, keys))
+        assert feature_ops.ngrams(n, keys[:n - 1]).shape == (0,)
+        assert feature_ops.ngrams(0, keys).shape == (0,)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("round_to", [1, 4])
+@pytest.mark.parametrize("lengths", [[3], [4, 0, 1, 7]])
+def test_pad(cpu_feature, dtype, round_to, lengths):
+    seqs = ragged_seqs(lengths, 6, dtype)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        padded = feature_ops.pad(seqs, round_to=round_to)
+        assert padded.dtype == dtype
+        assert np.array_equal(padded, numpy_ops.pad(seqs, round_to=round_to))
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("D", [1, 2, 7, 32, 33])
+def test_position_encode(cpu_feature, D):
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        expected = numpy_ops.position_encode(100, D)
+        encoding = feature_ops.position_encode(100, D)
+        assert encoding.dtype == np.float32
+        assert np.allclose(encoding, expected, atol=1e-4)
+
+        # Shorter requests are served from the cache.
+        assert np.array_equal(feature_ops.position_encode(10, D), encoding[:10])
+        assert np.allclose(feature_ops.position_encode(200, D)[:100], expected, atol=1e-4)
+
+        # Results are copies that can be modified without affecting the cache.
+        encoding[...] = 0
+        assert np.allclose(feature_ops.position_encode(100, D), expected, atol=1e-4)
+
+        out = np.empty((50, D), dtype="f")
+        assert feature_ops.position_encode(50, D, out=out) is out
+        assert np.allclose(out, expected[:50], atol=1e-4)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("offset", [0, 1])
+def test_random_normal(cpu_feature, dtype, offset):
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        out = feature_ops.random_normal(np.empty((300, 101), dtype=dtype), 1.0, 2.0, seed=3)
+        assert abs(out.mean() - 1.0) < 0.05
+        assert abs(out.std() - 2.0) < 0.05
+        # Fraction within one standard deviation.
+        assert abs((np.abs(out - 1.0) < 2.0).mean() - 0.6827) < 0.01
+
+        tail = feature_ops.random_normal(
+            np.empty(999, dtype=dtype), 1.0, 2.0, seed=3, offset=offset
+        )
+        assert np.allclose(tail, out.ravel()[offset : offset + 999])
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+def test_random_uniform(cpu_feature, dtype):
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        out = np.empty((300, 101), dtype=dtype)
+        assert feature_ops.random_uniform(out, -2.0, 3.0, seed=1) is out
+        assert out.min() >= -2.0 and out.max() < 3.0
+        assert abs(out.mean() - 0.5) < 0.05
+        assert abs(out.var() - 25 / 12) < 0.05
+
+        tail = feature_ops.random_uniform(np.empty(1000, dtype=dtype), -2.0, 3.0, seed=1, offset=7)
+        assert np.allclose(tail, out.ravel()[7:1007])
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("save_sum", [True, False])
+@pytest.mark.parametrize("shape", [(7, 13), (3, 64), (1, 1)])
+def test_residual_layer_norm(cpu_feature, dtype, save_sum, shape):
+    X = np.random.normal(size=shape).astype(dtype)
+    R = np.random.normal(size=shape).astype(dtype)
+    G = np.random.normal(size=shape[1]).astype(dtype)
+    b = np.random.normal(size=shape[1]).astype(dtype)
+    S_check = X + R
+    mean_check = S_check.mean(axis=1)
+    var_check = S_check.var(axis=1) + 1e-8
+    Y_check = (S_check - mean_check[:, None]) / np.sqrt(var_check[:, None]) * G + b
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        Y, S, mean, var = feature_ops.residual_layer_norm(X, R, G, b, save_sum=save_sum)
+        assert Y.dtype == dtype
+        if save_sum:
+            assert np.allclose(S, S_check)
+        else:
+            assert S is None
+        assert np.allclose(mean, mean_check, atol=1e-5)
+        assert np.allclose(var, var_check, atol=1e-5)
+        assert np.allclose(Y, Y_check, atol=1e-3)
+        with pytest.raises(ValueError):
+            feature_ops.residual_layer_norm(X, R[:, 0], G, b)
+
+
+def numpy_sample(X, temperature, top_p, u):
+    p = np.exp((X - X.max(axis=-1, keepdims=True)) / temperature)
+    # Keep the most probable entries with mass top_p, and ties of the last.
+    p_sorted = -np.sort(-p, axis=-1)
+    cumulative = np.cumsum(p_sorted, axis=-1)
+    n_kept = (cumulative < top_p * cumulative[..., -1:]).sum(axis=-1, keepdims=True)
+    threshold = np.take_along_axis(p_sorted, np.minimum(n_kept, p.shape[-1] - 1), axis=-1)
+    p = np.where(p >= threshold, p, 0.0)
+    cumulative = np.cumsum(p, axis=-1)
+    return (cumulative <= u[..., None] * cumulative[..., -1:]).sum(axis=-1)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("temperature", [0.5, 1.0, 2.0])
+@pytest.mark.parametrize("top_p", [0.1, 0.9, 1.0])
+@pytest.mark.parametrize("shape", [(200, 7), (20, 5, 67)])
+def test_sample(cpu_feature, dtype, temperature, top_p, shape):
+    X = np.random.normal(scale=3.0, size=shape).astype(dtype)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        which = feature_ops.sample(X, temperature=temperature, top_p=top_p, seed=5, offset=3)
+        u = feature_ops.random_uniform(np.empty(shape[:-1]), seed=5, offset=3)
+        assert which.shape == shape[:-1]
+        # Rounding can move a sample across a boundary of the cumulative mass.
+        tol = 1e-4 if dtype == np.float32 else 1e-12
+        which_lo = numpy_sample(X.astype(np.float64), temperature, top_p, u * (1 - tol))
+        which_hi = numpy_sample(X.astype(np.float64), temperature, top_p, u * (1 + tol))
+        assert np.all((which_lo <= which) & (which <= which_hi))
+
+        assert np.array_equal(feature_ops.sample(X, temperature=0.0), X.argmax(axis=-1))
+        assert np.array_equal(feature_ops.sample(X, top_p=1e-6, seed=5), X.argmax(axis=-1))
+        with pytest.raises(ValueError):
+            feature_ops.sample(X, top_p=0.0)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("nO", [1, 9, 64])
+def test_scatter_add(cpu_feature, dtype, nO):
+    table = np.random.normal(size=(10, nO)).astype(dtype)
+    # Repeated indices must accumulate, negative indices are skipped.
+    indices = np.array([3, 0, 3, 9, -1, 3, 0], dtype=np.int32)
+    values = np.random.normal(size=(indices.size, nO)).astype(dtype)
+    expected = table.copy()
+    np.add.at(expected, indices[indices >= 0], values[indices >= 0])
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        feature_ops.scatter_add(table, indices, values)
+        assert np.allclose(table, expected, atol=1e-5)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("nW", [0, 1, 2, 5])
+@pytest.mark.parametrize("lengths", [None, [3, 0, 1, 7, 4]])
+def test_seq2col(cpu_feature, dtype, nW, lengths):
+    X = np.random.normal(size=(15, 11)).astype(dtype)
+    lengths = None if lengths is None else np.array(lengths, dtype=np.int32)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        Y = feature_ops.seq2col(X, nW, lengths=lengths)
+        assert Y.dtype == dtype
+        assert np.array_equal(Y, numpy_ops.seq2col(X, nW, lengths=lengths))
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("nW", [0, 1, 2, 5])
+@pytest.mark.parametrize("lengths", [None, [3, 0, 1, 7, 4]])
+def test_backprop_seq2col(cpu_feature, dtype, nW, lengths):
+    dY = np.random.normal(size=(15, (2 * nW + 1) * 11)).astype(dtype)
+    lengths = None if lengths is None else np.array(lengths, dtype=np.int32)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        dX = feature_ops.backprop_seq2col(dY, nW, lengths=lengths)
+        assert dX.dtype == dtype
+        assert np.allclose(
+            dX, numpy_ops.backprop_seq2col(dY, nW, lengths=lengths), atol=1e-5
+        )
+
+
+def test_seq2col_invalid_lengths(ops):
+    X = np.zeros((5, 3), dtype=np.float32)
+    with pytest.raises(ValueError):
+        ops.seq2col(X, 1, lengths=np.array([2, 2], dtype=np.int32))
+    with pytest.raises(ValueError):
+        ops.seq2col(X, 1, lengths=np.array([6, -1], dtype=np.int32))
+
+
 @pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
 @pytest.mark.parametrize("dtype", [np.float32, np.float64])
 @pytest.mark.parametrize("inplace", [True, False])
@@ -254,3 +1115,71 @@ def test_swish_backward_torch(ops, cpu_feature, dtype, inplace):
 @pytest.mark.parametrize("X", test_inputs())
 def test_tanh(ops, cpu_feature, dtype, inplace, X):
     check_elementwise_function("tanh", np.tanh, cpu_feature, dtype, inplace, X)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("k", [1, 5, 32, 40])
+@pytest.mark.parametrize("shape", [(7, 50), (3, 5, 67)])
+def test_top_k(cpu_feature, dtype, k, shape):
+    X = np.random.normal(size=shape).astype(dtype)
+    # Ties must be ordered by index.
+    X.reshape(-1, shape[-1])[0, ::3] = 5.0
+    indices_check = np.argsort(-X, axis=-1, kind="stable")[..., :k]
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        values, indices = feature_ops.top_k(X, k)
+        assert values.dtype == dtype
+        assert np.array_equal(indices, indices_check)
+        assert np.array_equal(values, np.take_along_axis(X, indices_check, axis=-1))
+        with pytest.raises(ValueError):
+            feature_ops.top_k(X, shape[-1] + 1)
+
+        # NaN is the largest value, also when it follows larger values.
+        rows = X.reshape(-1, shape[-1]).copy()
+        rows[0, -1] = np.nan
+        rows[1, 3] = rows[1, -2] = np.nan
+        rows[2, :] = np.inf
+        rows[2, -1] = np.nan
+        indices_check = [
+            sorted(range(len(row)), key=lambda j: (not np.isnan(row[j]), np.nan_to_num(-row[j]), j))[:k]
+            for row in rows
+        ]
+        values, indices = feature_ops.top_k(rows, k)
+        assert np.array_equal(indices, indices_check)
+        values_check = np.take_along_axis(rows, np.array(indices_check), axis=-1)
+        assert np.array_equal(values, values_check, equal_nan=True)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+@pytest.mark.parametrize("t", [1, 100, 10**6])
+def test_update_averages(cpu_feature, dtype, t):
+    ema = np.random.normal(size=(7, 9)).astype(dtype)
+    weights = np.random.normal(size=(7, 9)).astype(dtype)
+    expected = ema.copy()
+    numpy_ops.update_averages(expected, weights, t)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        feature_ops.update_averages(ema, weights, t)
+        assert np.allclose(ema, expected, atol=1e-6)
+
+        with pytest.raises(ValueError):
+            feature_ops.update_averages(ema, weights.astype(np.float16), t)
+
+
+@pytest.mark.parametrize("cpu_feature", SleefOps.instruction_sets())
+@pytest.mark.parametrize("dtype", [np.float32, np.float64])
+def test_update_averages_multi(cpu_feature, dtype):
+    sizes = [1, 13, 64]
+    emas = [np.random.normal(size=n).astype(dtype) for n in sizes]
+    weights = [np.random.normal(size=n).astype(dtype) for n in sizes]
+    expected = [ema.copy() for ema in emas]
+    for ema, w in zip(expected, weights):
+        numpy_ops.update_averages(ema, w, 5)
+    with with_cpu_feature(cpu_feature) as feature_ops:
+        feature_ops.update_averages_multi(emas, weights, 5)
+        for ema, e in zip(emas, expected):
+            assert np.allclose(ema, e, atol=1e-6)
+
+        feature_ops.update_averages_multi([], [], 5)
+        with pytest.raises(ValueError):
+            feature_ops.update_averages_multi(emas, weights[:-1], 5)